@@ -0,0 +1,22 @@
+#include "arena.h"
+
+namespace JsonCPP {
+constexpr size_t StringArena::blockSize;
+
+StringArena::StringArena() : m_current(nullptr), m_end(nullptr) {}
+
+char* StringArena::alloc(size_t n) {
+    // Keep the bump pointer 4-byte aligned so length prefixes written at the
+    // start of an allocation can be read back as an unsigned.
+    n = (n + 3) & ~size_t(3);
+    if (static_cast<size_t>(m_end - m_current) < n) {
+        size_t size = n > blockSize ? n : blockSize;
+        m_blocks.emplace_back(new char[size]);
+        m_current = m_blocks.back().get();
+        m_end = m_current + size;
+    }
+    char* result = m_current;
+    m_current += n;
+    return result;
+}
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace JsonCPP {
+/**
+ * Bump allocator for string payloads that live and die with a parsed
+ * document. alloc() is a pointer add inside the current block; the whole
+ * pool is released in O(number of blocks) when the arena goes away, instead
+ * of one delete[] per string.
+ */
+class StringArena {
+public:
+    static constexpr size_t blockSize = 32 * 1024;
+
+    StringArena();
+    StringArena(const StringArena&) = delete;
+    StringArena& operator=(const StringArena&) = delete;
+
+    char* alloc(size_t n);
+
+private:
+    char* m_current;
+    char* m_end;
+    std::vector<std::unique_ptr<char[]>> m_blocks;
+};
+}
@@ -1,18 +1,18 @@
 #include "except.h"
 
 namespace JsonCPP {
-Exception::Exception(const std::string& msg) : m_msg(msg) {}
+Exception::Exception(std::string msg) : m_msg(std::move(msg)) {}
 
 Exception::~Exception() noexcept = default;
 
 char const* Exception::what() const noexcept {
     return m_msg.c_str();
 }
-void throwRuntimeError(const std::string& msg) {
-    throw RuntimeError(msg);
+void throwRuntimeError(std::string msg) {
+    throw RuntimeError(std::move(msg));
 }
 
-void throwLogicError(const std::string& msg) {
-    throw LogicError(msg);
+void throwLogicError(std::string msg) {
+    throw LogicError(std::move(msg));
 }
 }
\ No newline at end of file
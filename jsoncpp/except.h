@@ -1,13 +1,15 @@
 #pragma once
 
 #include <exception>
-#include <sstream>
 #include <string>
+#include <type_traits>
+#include <utility>
+#include "except_fwd.h"
 
 namespace JsonCPP {
 class Exception : public std::exception {
 public:
-    Exception(const std::string& msg);
+    Exception(std::string msg);
     ~Exception() noexcept override;
     const char* what() const noexcept override;
 
@@ -17,28 +19,56 @@ private:
 
 class RuntimeError : public Exception {
 public:
-    RuntimeError(const std::string& msg) : Exception(msg) {}
+    RuntimeError(std::string msg) : Exception(std::move(msg)) {}
 };
 
 class LogicError : public Exception {
 public:
-    LogicError(const std::string& msg) : Exception(msg) {}
+    LogicError(std::string msg) : Exception(std::move(msg)) {}
 };
 
-void throwRuntimeError(const std::string& msg);
-void throwLogicError(const std::string& msg);
+// The throw helpers are declared in except_fwd.h: noreturn/cold keeps the
+// failure branch out of the caller's hot path and lets the compiler drop the
+// "assert may return" bookkeeping at every call site.
+namespace detail {
+inline void appendPart(std::string& out, const char* part) { out += part; }
+inline void appendPart(std::string& out, const std::string& part) { out += part; }
+inline void appendPart(std::string& out, char part) { out += part; }
+template <typename T>
+inline typename std::enable_if<std::is_arithmetic<T>::value>::type
+appendPart(std::string& out, T part) { out += std::to_string(part); }
+
+inline void buildMessage(std::string&) {}
+template <typename First, typename... Rest>
+inline void buildMessage(std::string& out, First&& first, Rest&&... rest) {
+    appendPart(out, std::forward<First>(first));
+    buildMessage(out, std::forward<Rest>(rest)...);
+}
+}
+
+/**
+ * Cold-path assembly of an assertion message from loose parts with a single
+ * std::string; no stringstream (and therefore no locale/iostream machinery)
+ * is pulled into call sites of the assert macros.
+ */
+template <typename... Parts>
+[[noreturn]] __attribute__((cold)) inline void throwLogicErrorFmt(Parts&&... parts) {
+    std::string msg;
+    detail::buildMessage(msg, std::forward<Parts>(parts)...);
+    throwLogicError(std::move(msg));
+}
 }
 
-#define JSON_ASSERT(condition)                          \
-    if (!(condition)) {                                 \
-        JsonCPP::throwLogicError("assert json failed"); \
-        abort();                                        \
-    }
-
-#define JSON_ASSERT_MESSAGE(condition, message) \
-    if (!(condition)) {                         \
-        std::stringstream ss;                   \
-        ss << message;                          \
-        JsonCPP::throwLogicError(ss.str());     \
-        abort();                                \
-    }
+#define JSON_ASSERT(condition)                              \
+    do {                                                    \
+        if (__builtin_expect(!(condition), 0)) {            \
+            JsonCPP::throwLogicError("assert json failed"); \
+        }                                                   \
+    } while (0)
+
+#define JSON_ASSERT_MESSAGE(condition, message)  \
+    do {                                         \
+        if (__builtin_expect(!(condition), 0)) { \
+            JsonCPP::throwLogicErrorFmt(message);\
+        }                                        \
+    } while (0)
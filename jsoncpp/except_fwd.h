@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string>
+
+// Forward declarations for the exception machinery: enough to raise an error,
+// without pulling the class definitions and assert macros of except.h into
+// every translation unit.
+namespace JsonCPP {
+class Exception;
+class RuntimeError;
+class LogicError;
+
+[[noreturn]] __attribute__((cold)) void throwRuntimeError(std::string msg);
+[[noreturn]] __attribute__((cold)) void throwLogicError(std::string msg);
+}
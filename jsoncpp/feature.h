@@ -1,21 +1,38 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <string>
 
 namespace JsonCPP {
 class Features {
 public:
-    static Features All();
-    static Features StrictMode();
+    // One bit per setting; a reader can test several settings with a single
+    // byte load and mask instead of four separate bool loads.
+    enum : uint8_t {
+        kAllowComments = 1,
+        kStrictRoot = 2,
+        kAllowDroppedNullPlaceholders = 4,
+        kAllowNumericKeys = 8
+    };
+
+    static constexpr Features All() { return Features(); }
+    static constexpr Features StrictMode() { return Features(kStrictRoot); }
 
-    Features();
+    constexpr Features() : m_flags(kAllowComments) {}
+
+    constexpr bool allowComments() const { return (m_flags & kAllowComments) != 0; }
+    constexpr bool strictRoot() const { return (m_flags & kStrictRoot) != 0; }
+    constexpr bool allowDroppedNullPlaceholders() const {
+        return (m_flags & kAllowDroppedNullPlaceholders) != 0;
+    }
+    constexpr bool allowNumericKeys() const { return (m_flags & kAllowNumericKeys) != 0; }
+    constexpr uint8_t flags() const { return m_flags; }
 
 private:
-    bool m_allowComments;
-    bool m_strictRoot;
-    bool m_allowDroppedNullPlaceholders;
-    bool m_allowNumericKeys;
+    constexpr Features(uint8_t flags) : m_flags(flags) {}
+
+    uint8_t m_flags;
 };
 
 class Reader {
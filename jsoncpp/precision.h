@@ -0,0 +1,15 @@
+#pragma once
+
+// Formatting precision knobs shared by value.h and utils.h; a separate header
+// so serializing numbers does not pull the whole Value definition into the
+// translation unit.
+namespace JsonCPP {
+/// @brief Type of precision for formatting of real values.
+enum PrecisionType {
+    significantDigits = 0,  // we set max number of significant digits in string
+    decimalPlaces           // we set max number of digits after "." in string
+};
+
+// Number of significant digits needed to round-trip a double.
+constexpr unsigned int defaultRealPrecision = 17;
+}
@@ -1,93 +1,303 @@
 #include <cmath>
 #include <cstdio>
+#include <cstring>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
 #include "except.h"
 #include "utils.h"
 
 namespace JsonCPP {
+// "00".."99" as one flat table so the conversion loop peels two digits per
+// division instead of one; the division unit dominates integer-to-string cost.
+static const char digitPairs[] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+// Emit exactly eight digits, leading zeros included. Every divisor is a
+// constant, so the compiler lowers all of this to multiply-shift sequences:
+// no real division and no branch per digit.
+static inline void writeEightDigits(uint32_t value, char* out) {
+    uint32_t hi = value / 10000;
+    uint32_t lo = value % 10000;
+    memcpy(out + 0, &digitPairs[(hi / 100) * 2], 2);
+    memcpy(out + 2, &digitPairs[(hi % 100) * 2], 2);
+    memcpy(out + 4, &digitPairs[(lo / 100) * 2], 2);
+    memcpy(out + 6, &digitPairs[(lo % 100) * 2], 2);
+}
+
 static void uintToString(uint64_t value, char*& current) {
-    *--current = 0;
-    do {
-        *--current = static_cast<char>(value % 10U + static_cast<unsigned>('0'));
-        value /= 10;
-    } while (value != 0);
+    // Peel fixed-width blocks of eight digits first: one 64-bit
+    // multiply-shift per block replaces eight dependent divisions, and a
+    // full uint64 takes at most two blocks before the tail.
+    while (value >= 100000000) {
+        uint32_t low8 = static_cast<uint32_t>(value % 100000000);
+        value /= 100000000;
+        current -= 8;
+        writeEightDigits(low8, current);
+    }
+    uint32_t head = static_cast<uint32_t>(value);
+    while (head >= 100) {
+        uint32_t pair = head % 100;
+        head /= 100;
+        current -= 2;
+        memcpy(current, &digitPairs[pair * 2], 2);
+    }
+    if (head >= 10) {
+        current -= 2;
+        memcpy(current, &digitPairs[head * 2], 2);
+    } else {
+        *--current = static_cast<char>('0' + head);
+    }
 }
 
-std::string valueToString(int64_t value) {
+unsigned int writeTo(char* out, int64_t value) {
     char buffer[3 * 64 / 8 + 1];
-    char* current = buffer + sizeof(buffer);
-    if (value == Value::minInt64) {
-        uintToString(uint64_t(Value::maxInt64) + 1, current);
-        *--current = '-';
-    } else if (value < 0) {
-        uintToString(uint64_t(-value), current);
+    char* const bufferEnd = buffer + sizeof(buffer);
+    char* current = bufferEnd;
+    uint64_t magnitude = static_cast<uint64_t>(value);
+    if (value < 0) {
+        magnitude = 0u - magnitude; // wraps to 2^63 for minInt64
+    }
+    uintToString(magnitude, current);
+    if (value < 0) {
         *--current = '-';
-    } else {
-        uintToString(uint64_t(value), current);
     }
     JSON_ASSERT(current >= buffer);
-    return current;
+    unsigned int length = static_cast<unsigned int>(bufferEnd - current);
+    memcpy(out, current, length);
+    return length;
 }
 
-std::string valueToString(uint64_t value) {
+unsigned int writeTo(char* out, uint64_t value) {
     char buffer[3 * 64 / 8 + 1];
-    char* current = buffer + sizeof(buffer);
+    char* const bufferEnd = buffer + sizeof(buffer);
+    char* current = bufferEnd;
     uintToString(value, current);
     JSON_ASSERT(current >= buffer);
-    return current;
+    unsigned int length = static_cast<unsigned int>(bufferEnd - current);
+    memcpy(out, current, length);
+    return length;
+}
+
+std::string valueToString(int64_t value) {
+    char buffer[3 * 64 / 8 + 1];
+    return std::string(buffer, writeTo(buffer, value));
+}
+
+std::string valueToString(uint64_t value) {
+    char buffer[3 * 64 / 8 + 1];
+    return std::string(buffer, writeTo(buffer, value));
+}
+
+// 32-bit sibling of uintToString: the divisions stay on the 32-bit divider,
+// which is markedly faster than the 64-bit path these overloads used to
+// delegate to.
+static void uint32ToString(uint32_t value, char*& current) {
+    while (value >= 100) {
+        uint32_t pair = value % 100;
+        value /= 100;
+        current -= 2;
+        memcpy(current, &digitPairs[pair * 2], 2);
+    }
+    if (value >= 10) {
+        current -= 2;
+        memcpy(current, &digitPairs[value * 2], 2);
+    } else {
+        *--current = static_cast<char>('0' + value);
+    }
+}
+
+unsigned int writeTo(char* out, int32_t value) {
+    char buffer[sizeof("-2147483648")];
+    char* const bufferEnd = buffer + sizeof(buffer);
+    char* current = bufferEnd;
+    if (value < 0) {
+        uint32ToString(0u - static_cast<uint32_t>(value), current); // wraps for minInt
+        *--current = '-';
+    } else {
+        uint32ToString(static_cast<uint32_t>(value), current);
+    }
+    JSON_ASSERT(current >= buffer);
+    unsigned int length = static_cast<unsigned int>(bufferEnd - current);
+    memcpy(out, current, length);
+    return length;
+}
+
+unsigned int writeTo(char* out, uint32_t value) {
+    char buffer[sizeof("4294967295")];
+    char* const bufferEnd = buffer + sizeof(buffer);
+    char* current = bufferEnd;
+    uint32ToString(value, current);
+    JSON_ASSERT(current >= buffer);
+    unsigned int length = static_cast<unsigned int>(bufferEnd - current);
+    memcpy(out, current, length);
+    return length;
 }
 
 std::string valueToString(int32_t value) {
-    return valueToString(int64_t(value));
+    char buffer[sizeof("-2147483648")];
+    return std::string(buffer, writeTo(buffer, value));
 }
 
 std::string valueToString(uint32_t value) {
-    return valueToString(uint64_t(value));
+    char buffer[sizeof("4294967295")];
+    return std::string(buffer, writeTo(buffer, value));
 }
 
-std::string valueToString(bool value) {
+// Representations of non-finite doubles, indexed by [useSpecialFloats][kind]
+// with kind 0 = NaN, 1 = -Infinity, 2 = Infinity.
+static const char* const nonFiniteReps[2][3] = {{"null", "-1e+9999", "1e+9999"},
+                                                {"NaN", "-Infinity", "Infinity"}};
+
+const char* valueToCString(bool value) {
     return value ? "true" : "false";
 }
 
+const char* nonFiniteToCString(double value, bool useSpecialFloats) {
+    // signbit is a plain bit test, so the kind index needs no comparison
+    // against zero and only the NaN check remains a branch source.
+    int kind = std::isnan(value) ? 0 : 2 - static_cast<int>(std::signbit(value));
+    return nonFiniteReps[static_cast<int>(useSpecialFloats)][kind];
+}
+
+std::string valueToString(bool value) {
+    return valueToCString(value);
+}
+
 std::string valueToString(double value, unsigned int precision, PrecisionType precisionType) {
     return valueToString(value, false, precision, precisionType);
 }
 
-std::string valueToString(double value, bool useSpecialFloats,
+void writeDoubleTo(std::string& out, double value, bool useSpecialFloats,
     unsigned int precision, PrecisionType precisionType) {
     // Print into the buffer. We need not request the alternative representation
     // that always has a decimal point because JSON doesn't distinguish the
     // concepts of reals and integers.
-    if (!std::isfinite(value)) {
-        static const char* const reps[2][3] = {{"NaN", "-Infinity", "Infinity"},
-                                               {"null", "-1e+9999", "1e+9999"}};
-        return reps[useSpecialFloats ? 0 : 1][std::isnan(value) ? 0 : (value < 0) ? 1 : 2];
-    }
-    std::string buffer(size_t(36), '\0');
-    while (true) {
-        int len = std::snprintf(&*buffer.begin(), buffer.size(),
-            (precisionType == PrecisionType::significantDigits) ? "%.*g" : "%.*f",
-            precision, value);
-        JSON_ASSERT(len >= 0);
-        size_t wouldPrint = static_cast<size_t>(len);
-        if (wouldPrint >= buffer.size()) {
-            buffer.resize(wouldPrint + 1);
-            continue;
-        }
-        buffer.resize(wouldPrint);
-        break;
+    if (__builtin_expect(!std::isfinite(value), 0)) {
+        out += nonFiniteToCString(value, useSpecialFloats);
+        return;
     }
-    buffer.erase(fixNumericLocale(buffer.begin(), buffer.end()), buffer.end());
+    // Format into a stack buffer first; any precision <= 22 fits, so the
+    // common path appends to out exactly once instead of sizing a heap
+    // string up front and resizing it after the fact.
+    char stack[32];
+    const char* format =
+        (precisionType == PrecisionType::significantDigits) ? "%.*g" : "%.*f";
+    int len = std::snprintf(stack, sizeof(stack), format, precision, value);
+    JSON_ASSERT(len >= 0);
+    size_t wouldPrint = static_cast<size_t>(len);
+    size_t start = out.size();
+    if (__builtin_expect(wouldPrint < sizeof(stack), 1)) {
+        out.append(stack, wouldPrint);
+    } else {
+        // Oversized fixed-precision request: retry once with the exact size.
+        out.resize(start + wouldPrint + 1);
+        std::snprintf(&out[start], wouldPrint + 1, format, precision, value);
+        out.resize(start + wouldPrint);
+    }
+    fixNumericLocale(&out[start], &out[0] + out.size());
     // try to ensure we preserve the fact that this was given to us as a double on input
-    if (buffer.find('.') == buffer.npos && buffer.find('e') == buffer.npos) {
-        buffer += ".0";
+    if (out.find('.', start) == out.npos && out.find('e', start) == out.npos) {
+        out += ".0";
     }
 
     // strip the zero padding from the right
     if (precisionType == PrecisionType::decimalPlaces) {
-        buffer.erase(fixZerosInTheEnd(buffer.begin(), buffer.end(), precision),
-                    buffer.end());
+        out.erase(fixZerosInTheEnd(out.begin() + start, out.end(), precision),
+                    out.end());
     }
+}
 
+std::string valueToString(double value, bool useSpecialFloats,
+    unsigned int precision, PrecisionType precisionType) {
+    std::string buffer;
+    writeDoubleTo(buffer, value, useSpecialFloats, precision, precisionType);
     return buffer;
 }
-}
\ No newline at end of file
+
+// ---- json_memcmp_wide dispatch -------------------------------------------
+// Callers guarantee n >= 16 (utils.h routes shorter inputs to libc), so the
+// variants never need a scalar head loop.
+
+#if defined(__x86_64__)
+static int json_memcmp_sse2(const char* a, const char* b, size_t n) {
+    size_t i = 0;
+    do {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(x, y));
+        if (mask != 0xffff) {
+            size_t diff = i + __builtin_ctz(~mask);
+            return static_cast<unsigned char>(a[diff]) - static_cast<unsigned char>(b[diff]);
+        }
+        i += 16;
+    } while (i + 16 <= n);
+    if (i == n) {
+        return 0;
+    }
+    // Overlapping tail: re-compare the final 16 bytes.
+    i = n - 16;
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+    int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(x, y));
+    if (mask != 0xffff) {
+        size_t diff = i + __builtin_ctz(~mask);
+        return static_cast<unsigned char>(a[diff]) - static_cast<unsigned char>(b[diff]);
+    }
+    return 0;
+}
+
+__attribute__((target("avx2")))
+static int json_memcmp_avx2(const char* a, const char* b, size_t n) {
+    size_t i = 0;
+    while (i + 32 <= n) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y)));
+        if (mask != 0xffffffffu) {
+            size_t diff = i + __builtin_ctz(~mask);
+            return static_cast<unsigned char>(a[diff]) - static_cast<unsigned char>(b[diff]);
+        }
+        i += 32;
+    }
+    if (i == n) {
+        return 0;
+    }
+    if (n >= 32) {
+        // Overlapping tail: re-compare the final 32 bytes.
+        i = n - 32;
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y)));
+        if (mask != 0xffffffffu) {
+            size_t diff = i + __builtin_ctz(~mask);
+            return static_cast<unsigned char>(a[diff]) - static_cast<unsigned char>(b[diff]);
+        }
+        return 0;
+    }
+    return json_memcmp_sse2(a + i, b + i, n - i);
+}
+#else
+static int json_memcmp_generic(const char* a, const char* b, size_t n) {
+    return memcmp(a, b, n);
+}
+#endif
+
+static int (*resolveMemcmp())(const char*, const char*, size_t) {
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return json_memcmp_avx2;
+    }
+    return json_memcmp_sse2; // baseline for x86-64
+#else
+    return json_memcmp_generic;
+#endif
+}
+
+int (*const json_memcmp_wide)(const char* a, const char* b, size_t n) = resolveMemcmp();
+}
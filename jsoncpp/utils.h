@@ -1,18 +1,48 @@
 #pragma once
 
+#include <cstdint>
+#include <cstring>
 #include <string>
-#include "value.h"
+#include "precision.h"
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 namespace JsonCPP {
+/**
+ * Write the decimal form of value into out and return the number of bytes
+ * written; no terminator is added. The caller guarantees at least 24 bytes.
+ * Writers can serialize numbers straight into their output buffer with no
+ * std::string in between.
+ */
+unsigned int writeTo(char* out, int64_t value);
+unsigned int writeTo(char* out, uint64_t value);
+unsigned int writeTo(char* out, int32_t value);
+unsigned int writeTo(char* out, uint32_t value);
+
 std::string valueToString(int64_t value);
 std::string valueToString(uint64_t value);
 std::string valueToString(int32_t value);
 std::string valueToString(uint32_t value);
 std::string valueToString(bool value);
-std::string valueToString(double value, unsigned int precision = Value::defaultRealPrecision,
+/**
+ * Allocation-free forms for outputs that are string constants; writers can
+ * emit the returned literal directly instead of materializing a std::string.
+ */
+const char* valueToCString(bool value);
+const char* nonFiniteToCString(double value, bool useSpecialFloats);
+std::string valueToString(double value, unsigned int precision = JsonCPP::defaultRealPrecision,
     PrecisionType precisionType = PrecisionType::significantDigits);
 std::string valueToString(double value, bool useSpecialFloats,
     unsigned int precision, PrecisionType precisionType);
+/**
+ * Append the formatted double to out. Streaming writers reuse one string
+ * across calls, so its capacity stabilizes and the per-value allocation of
+ * the returning overloads disappears.
+ */
+void writeDoubleTo(std::string& out, double value, bool useSpecialFloats = false,
+    unsigned int precision = JsonCPP::defaultRealPrecision,
+    PrecisionType precisionType = PrecisionType::significantDigits);
 
 /**
  * Change ',' to '.' everywhere in buffer.
@@ -27,6 +57,52 @@ Iter fixNumericLocale(Iter begin, Iter end) {
     return begin;
 }
 
+/**
+ * Overload for plain char buffers: scan 16 bytes at a time under SSE2 and
+ * only rewrite a block when it actually contains a ','; the scalar loop
+ * handles the tail (and the whole range on non-SSE2 targets).
+ */
+inline char* fixNumericLocale(char* begin, char* end) {
+#if defined(__SSE2__)
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i period = _mm_set1_epi8('.');
+    while (end - begin >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+        __m128i mask = _mm_cmpeq_epi8(v, comma);
+        if (_mm_movemask_epi8(mask)) {
+            v = _mm_or_si128(_mm_andnot_si128(mask, v), _mm_and_si128(mask, period));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(begin), v);
+        }
+        begin += 16;
+    }
+#endif
+    for (; begin != end; ++begin) {
+        if (*begin == ',') {
+            *begin = '.';
+        }
+    }
+    return end;
+}
+
+/**
+ * Widest vector comparator the running CPU supports (AVX2 when available,
+ * else the SSE2 baseline), resolved once at load time so one binary serves
+ * every ISA level. Only defined for inputs of 16 bytes or more.
+ */
+extern int (*const json_memcmp_wide)(const char* a, const char* b, size_t n);
+
+/**
+ * memcmp replacement for the inline compare-then-branch pattern in the
+ * string comparators: libc stays on the short inputs where an indirect call
+ * would dominate, everything else goes through the dispatched vector loop.
+ */
+inline int json_memcmp(const char* a, const char* b, size_t n) {
+    if (n < 16) {
+        return memcmp(a, b, n);
+    }
+    return json_memcmp_wide(a, b, n);
+}
+
 /**
  * Return iterator that would be the new end of the range [begin,end), if we
  * were to delete zeros in the end of string, but not the last zero before '.'.
@@ -1,20 +1,15 @@
 #include <cmath>
 #include <cstddef>
 #include <cstring>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+#include "arena.h"
 #include "except.h"
 #include "utils.h"
 #include "value.h"
 
 namespace JsonCPP {
-template <typename T>
-static std::unique_ptr<T> cloneUnique(const std::unique_ptr<T>& p) {
-  std::unique_ptr<T> r;
-  if (p) {
-    r = std::unique_ptr<T>(new T(*p));
-  }
-  return r;
-}
-
 Value const& Value::nullSingleton() {
     static const Value nullStatic;
     return nullStatic;
@@ -31,12 +26,16 @@ static inline double integerToDouble(T value) {
 
 template <typename T, typename U>
 static inline bool InRange(double d, T min, U max) {
-    return d >= integerToDouble(min) && d <= integerToDouble(max);
+    // Bitwise & keeps this branch-free; both compares are a single ucomisd
+    // and the short-circuit would only add a mispredictable branch.
+    return static_cast<int>(d >= integerToDouble(min)) &
+           static_cast<int>(d <= integerToDouble(max));
 }
 
-static bool IsIntegral(double d) {
-    double integral_part;
-    return modf(d, &integral_part) == 0.0;
+static inline bool IsIntegral(double d) {
+    // trunc compiles to a single roundsd; modf is a libm call. NaN compares
+    // unequal to itself, so it stays non-integral, same as before.
+    return d == std::trunc(d);
 }
 
 static inline char* duplicateStringValue(const char* value, size_t length) {
@@ -69,113 +68,217 @@ static inline char* duplicateAndPrefixStringValue(const char* value, unsigned in
     return newString;
 }
 
-inline static void decodePrefixedString(bool isPrefixed, const char* prefixed,
-                                        unsigned* length, const char** value) {
-    if (!isPrefixed) {
-        *length = static_cast<unsigned>(strlen(prefixed));
-        *value = prefixed;
-    } else {
-        *length = *reinterpret_cast<const unsigned*>(prefixed);
-        *value = prefixed + sizeof(unsigned);
-    }
+// Arena flavor: same prefixed layout, but the block is bump-allocated and
+// freed wholesale with the arena rather than per string.
+static inline char* duplicateAndPrefixStringValue(StringArena& arena,
+                                                  const char* value, unsigned int length) {
+    JSON_ASSERT_MESSAGE(length <= static_cast<unsigned>(Value::maxInt) - sizeof(unsigned) - 1U,
+        "in Json::Value::duplicateAndPrefixStringValue(): length too big for prefixing");
+    size_t actualLength = sizeof(length) + length + 1;
+    char* newString = arena.alloc(actualLength);
+    *reinterpret_cast<unsigned*>(newString) = length;
+    memcpy(newString + sizeof(unsigned), value, length);
+    newString[actualLength - 1U] = 0;
+    return newString;
+}
+
+inline static void decodePrefixedString(const char* prefixed, unsigned* length,
+                                        const char** value) {
+    *length = *reinterpret_cast<const unsigned*>(prefixed);
+    *value = prefixed + sizeof(unsigned);
 }
 
-Value::CZString::CZString(uint32_t index) : m_cstr(nullptr), m_index(index) {}
+// Guards metaTable(). The table is process-wide so metadata set on one
+// thread reads back on any other; the has_meta/has_comments gates keep the
+// lock entirely off the metadata-free common path.
+static std::mutex metaTableMutex;
+
+constexpr unsigned Value::CZString::tagShift;
+constexpr unsigned Value::CZString::lenShift;
+constexpr uint64_t Value::CZString::lenMask;
+constexpr uint64_t Value::CZString::ptrMask;
+constexpr unsigned Value::CZString::inlineCapacity;
 
-Value::CZString::CZString(char const* str, unsigned int length, DuplicationPolicy allocate)
-    : m_cstr(str) {
-    m_storage.policy = allocate & 0x3;
-    m_storage.length = length & 0x3fffffff;
+Value::CZString::CZString(uint32_t index) : m_word((uint64_t(tagIndex) << tagShift) | index) {}
+
+// Zero the word first so the unused bytes are canonical, then fold the
+// length into the metadata bits. Because the padding is canonical and the
+// length lives in the word, the word itself is a collision-free hash of a
+// short key: two inline keys are equal iff their words are equal.
+void Value::CZString::storeInline(const char* str, unsigned int length) {
+    m_word = 0;
+    memcpy(m_bytes, str, length);
+    m_word |= (uint64_t(tagInline) << tagShift) | (uint64_t(length) << lenShift);
 }
 
-Value::CZString::CZString(CZString const& other) {
-    if (other.m_storage.policy != noDuplication && other.m_cstr != nullptr) {
-        m_cstr = duplicateStringValue(other.m_cstr, other.m_storage.length);
-    } else {
-        m_cstr = other.m_cstr;
+Value::CZString::CZString(char const* str, unsigned int length, DuplicationPolicy allocate) {
+    // Short keys live in place whenever this object owns or may own the
+    // bytes, so both stored keys and transient lookup keys land in the
+    // word-compare fast path below. noDuplication stays borrowed even when
+    // short: isStaticString() must keep reporting it.
+    if (allocate != noDuplication && length >= 1 && length <= inlineCapacity) {
+        storeInline(str, length);
+        return;
     }
-    if (other.m_cstr) {
-        if (static_cast<DuplicationPolicy>(other.m_storage.policy) == noDuplication) {
-            m_storage.policy = static_cast<unsigned int>(noDuplication) & 3U;
-        } else {
-            m_storage.policy = static_cast<unsigned int>(duplicate) & 3U;
+    if (allocate == duplicate || length > lenMask) {
+        // Owned keys take a length-prefixed copy that is freed with the
+        // map, so key memory stays bounded by the live trees. (Keys too
+        // long for the packed length field land here under any policy:
+        // the prefix carries their length.)
+        m_word = pack(tagPrefixed, 0, duplicateAndPrefixStringValue(str, length));
+        return;
+    }
+    Tag tag = allocate == noDuplication ? tagBorrowed
+            : allocate == arenaBorrowed  ? tagArena
+                                         : tagDupOnCopy;
+    m_word = pack(tag, length, str);
+}
+
+Value::CZString::CZString(CZString const& other) {
+    switch (other.tag()) {
+    case tagIndex:
+    case tagBorrowed:
+    case tagInline:
+        m_word = other.m_word;
+        break;
+
+    case tagDupOnCopy:
+    case tagArena: {
+        // A transient lookup key becomes persistent on insert, and an
+        // arena-borrowed key materializes when its tree is copied -- the
+        // copy may outlive the arena, the same rule dupPayload applies to
+        // arena string values.
+        unsigned len = other.length();
+        m_word = pack(tagPrefixed, 0, duplicateAndPrefixStringValue(other.pointer(), len));
+        break;
+        }
+
+    case tagPrefixed: {
+        unsigned len = *reinterpret_cast<const unsigned*>(other.pointer());
+        m_word = pack(tagPrefixed, 0,
+                      duplicateAndPrefixStringValue(other.pointer() + sizeof(unsigned), len));
+        break;
         }
-    } else {
-        m_storage.policy = static_cast<unsigned int>(other.m_storage.policy) & 3U;
     }
-    m_storage.length = other.m_storage.length;
 }
 
-Value::CZString::CZString(CZString&& other) noexcept
-    : m_cstr(other.m_cstr), m_index(other.m_index) {
-    other.m_cstr = nullptr;
+Value::CZString::CZString(CZString&& other) noexcept : m_word(other.m_word) {
+    other.m_word = uint64_t(tagIndex) << tagShift;
 }
 
 Value::CZString::~CZString() {
-    if (m_cstr && m_storage.policy == duplicate) {
-        delete[] m_cstr;
-        m_cstr = nullptr;
+    if (tag() == tagPrefixed) {
+        delete[] const_cast<char*>(pointer());
     }
 }
 
 void Value::CZString::swap(CZString& other) {
-    std::swap(m_cstr, other.m_cstr);
-    std::swap(m_index, other.m_index);
+    std::swap(m_word, other.m_word);
 }
 
+// Live keys get assigned now that ObjectValues is a vector: object reuse in
+// copyPayload copy-assigns pairs element-wise and erase shifts by move
+// assignment. Both forms must therefore release any prefixed block the
+// target owns -- a plain word copy would alias or leak it.
 Value::CZString& Value::CZString::operator=(const Value::CZString& other) {
-    m_cstr = other.m_cstr;
-    m_index = other.m_index;
+    // Copy-and-swap: the copy ctor deep-copies a prefixed key, and our old
+    // block dies with the temporary.
+    CZString copy(other);
+    swap(copy);
     return *this;
 }
 
 Value::CZString& Value::CZString::operator=(Value::CZString&& other) noexcept {
-    m_cstr = other.m_cstr;
-    m_index = other.m_index;
-    other.m_cstr = nullptr;
+    swap(other); // our old block is released when other is destroyed
     return *this;
 }
 
 bool Value::CZString::operator<(Value::CZString const& other) const {
-    if (m_cstr == nullptr) {
-        return m_index < other.m_index;
+    if (tag() == tagIndex) {
+        return index() < other.index();
     }
-    unsigned min_len = std::min<unsigned>(m_storage.length, other.m_storage.length);
-    JSON_ASSERT(m_cstr && other.m_cstr);
-    int ret = memcmp(m_cstr, other.m_cstr, min_len);
-    if (ret < 0) {
-        return true;
-    } else {
-        return false;
+    if (tag() == tagInline && other.tag() == tagInline) {
+        // The key bytes sit in the low 48 bits, zero-padded; bswap puts them
+        // in big-endian order so one integer compare gives memcmp order.
+        // Equal padded bytes fall through to the length tiebreak (keys may
+        // legitimately contain NUL).
+        uint64_t x = __builtin_bswap64(m_word & ptrMask);
+        uint64_t y = __builtin_bswap64(other.m_word & ptrMask);
+        if (x != y) {
+            return x < y;
+        }
+        return length() < other.length();
+    }
+    const char* a = data();
+    const char* b = other.data();
+    JSON_ASSERT(a && b);
+    unsigned this_len = length();
+    unsigned other_len = other.length();
+    if (a == b) { // borrowed keys may alias: same pointer means same bytes
+        return this_len < other_len;
+    }
+    // Keys past the inline fast path: libc memcmp handles the short ones,
+    // json_memcmp's dispatched 16/32-byte vector loop handles the rest, so
+    // long keys locate their first differing byte a register at a time.
+    unsigned n = std::min<unsigned>(this_len, other_len);
+    int ret = json_memcmp(a, b, n);
+    if (ret != 0) {
+        return ret < 0;
     }
-    return m_storage.length < other.m_storage.length;
+    // Equal common prefix: the shorter key sorts first. The old code returned
+    // before this tiebreak, making equal-prefix keys collide in the map.
+    return this_len < other_len;
 }
 
 bool Value::CZString::operator==(Value::CZString const& other) const {
-    if (m_cstr == nullptr) {
-        return m_index == other.m_index;
+    if (tag() == tagIndex) {
+        return index() == other.index();
     }
-    if (m_storage.length != other.m_storage.length) {
+    if (tag() == tagInline && other.tag() == tagInline) {
+        // The word is a collision-free hash of a short key (canonical
+        // padding, length folded into the metadata bits), so equality is a
+        // single integer compare -- no memcmp at all.
+        return m_word == other.m_word;
+    }
+    unsigned this_len = length();
+    if (this_len != other.length()) {
         return false;
     }
-    JSON_ASSERT(m_cstr && other.m_cstr);
-    int ret = memcmp(m_cstr, other.m_cstr, m_storage.length);
-    return ret == 0;
+    const char* a = data();
+    const char* b = other.data();
+    JSON_ASSERT(a && b);
+    if (a == b) { // borrowed keys may alias: same pointer means same bytes
+        return true;
+    }
+    return json_memcmp(a, b, this_len) == 0;
 }
 
 uint32_t Value::CZString::index() const {
-    return m_index;
+    return static_cast<uint32_t>(m_word);
 }
 
 char const* Value::CZString::data() const {
-    return m_cstr;
+    switch (tag()) {
+    case tagIndex:
+        return nullptr;
+    case tagInline:
+        return m_bytes;
+    case tagPrefixed:
+        return pointer() + sizeof(unsigned);
+    default:
+        return pointer();
+    }
 }
+
 unsigned int Value::CZString::length() const {
-    return m_storage.length;
+    if (tag() == tagPrefixed) {
+        return *reinterpret_cast<const unsigned*>(pointer());
+    }
+    return static_cast<unsigned>((m_word >> lenShift) & lenMask);
 }
 
 bool Value::CZString::isStaticString() const {
-    return m_storage.policy == noDuplication;
+    return tag() == tagBorrowed;
 }
 
 Value::Value(ValueType type) {
@@ -199,6 +302,9 @@ Value::Value(ValueType type) {
         break;
 
     case arrayValue:
+        m_value.v_array = new ArrayValues();
+        break;
+
     case objectValue:
         m_value.v_map = new ObjectValues();
         break;
@@ -212,166 +318,275 @@ Value::Value(ValueType type) {
     }
 }
 
-Value::Value(int32_t value) {
-    initBasic(intValue);
-    m_value.v_int = value;
-}
-
-Value::Value(uint32_t value) {
-    initBasic(uintValue);
-    m_value.v_uint = value;
-}
-
-Value::Value(int64_t value) {
-    initBasic(intValue);
-    m_value.v_int = value;
-}
-
-Value::Value(uint64_t value) {
-    initBasic(uintValue);
-    m_value.v_uint = value;
-}
-
-Value::Value(double value) {
-    initBasic(realValue);
-    m_value.v_real = value;
+Value::Value(const char* value) {
+    JSON_ASSERT_MESSAGE(value != nullptr, "Null Value Passed to Value Constructor");
+    storeString(value, static_cast<unsigned>(strlen(value)));
 }
 
-Value::Value(const char* value) {
-    initBasic(stringValue, true);
+Value::Value(const char* value, size_t length) {
     JSON_ASSERT_MESSAGE(value != nullptr, "Null Value Passed to Value Constructor");
-    m_value.v_string = duplicateAndPrefixStringValue(value, static_cast<unsigned>(strlen(value)));
+    storeString(value, static_cast<unsigned>(length));
 }
 
 Value::Value(const char* begin, const char* end) {
-    initBasic(stringValue, true);
-    m_value.v_string = duplicateAndPrefixStringValue(begin, static_cast<unsigned>(end - begin));
+    storeString(begin, static_cast<unsigned>(end - begin));
+}
+
+Value::Value(StringArena* arena, const char* begin, const char* end) {
+    JSON_ASSERT_MESSAGE(arena != nullptr, "Null arena passed to Value constructor");
+    unsigned length = static_cast<unsigned>(end - begin);
+    if (length < sizeof(m_value.v_sbuf)) {
+        storeString(begin, length); // short strings stay inline, arena unused
+        return;
+    }
+    initBasic(stringValue);
+    m_bits.arena_str = 1;
+    m_value.v_string = duplicateAndPrefixStringValue(*arena, begin, length);
+    m_strLen = length;
 }
 
 Value::Value(const StaticString& value) {
     initBasic(stringValue);
     m_value.v_string = const_cast<char*>(value.c_str());
+    m_strLen = static_cast<uint32_t>(value.length());
 }
 
 Value::Value(const std::string& value) {
-    initBasic(stringValue, true);
-    m_value.v_string = duplicateAndPrefixStringValue(value.data(),
-        static_cast<unsigned>(value.length()));
-}
-
-Value::Value(bool value) {
-    initBasic(boolValue);
-    m_value.v_bool = value;
+    storeString(value.data(), static_cast<unsigned>(value.length()));
 }
 
 Value::Value(const Value& other) {
     dupPayload(other);
-    dupMeta(other);
-}
-
-Value::Value(Value&& other) noexcept {
-    initBasic(nullValue);
-    swap(other);
+    m_bits.has_comments = 0;
+    m_bits.has_meta = 0;
+    if (__builtin_expect(other.m_bits.has_meta, 0)) {
+        dupMeta(other);
+    }
 }
 
 Value::~Value() {
+    if (__builtin_expect(m_bits.has_meta, 0)) {
+        std::lock_guard<std::mutex> lock(metaTableMutex);
+        metaTable().erase(this);
+    }
     releasePayload();
     m_value.v_uint = 0;
 }
 
 Value& Value::operator=(const Value& other) {
-    Value(other).swap(*this);
-    return *this;
-}
-
-Value& Value::operator=(Value&& other) noexcept {
-    other.swap(*this);
+    if (this == &other) {
+        return *this;
+    }
+    bool anyMeta = m_bits.has_meta | other.m_bits.has_meta;
+    copyPayload(other);
+    if (__builtin_expect(anyMeta, 0)) {
+        dupMeta(other);
+    }
     return *this;
 }
 
-void Value::swapPayload(Value& other) {
-    std::swap(m_bits, other.m_bits);
-    std::swap(m_value, other.m_value);
-}
-
 void Value::swap(Value& other) {
-    swapPayload(other);
-    std::swap(m_comments, other.m_comments);
-    std::swap(m_start, other.m_start);
-    std::swap(m_limit, other.m_limit);
+    bool thisHadComments = m_bits.has_comments;
+    bool thisHad = m_bits.has_meta;
+    bool otherHadComments = other.m_bits.has_comments;
+    bool otherHad = other.m_bits.has_meta;
+    swapPayload(other); // leaves each side's metadata bits in place
+    if (__builtin_expect(thisHad || otherHad, 0)) {
+        // A full swap moves the metadata with the value: exchange the flags
+        // swapPayload deliberately kept, then move the side-table entries,
+        // which are keyed by address, by hand.
+        m_bits.has_comments = otherHadComments;
+        m_bits.has_meta = otherHad;
+        other.m_bits.has_comments = thisHadComments;
+        other.m_bits.has_meta = thisHad;
+        std::lock_guard<std::mutex> lock(metaTableMutex);
+        std::unordered_map<const Value*, ValueMeta>& table = metaTable();
+        if (thisHad && otherHad) {
+            std::swap(table[this], table[&other]);
+        } else if (thisHad) {
+            table[&other] = std::move(table[this]);
+            table.erase(this);
+        } else {
+            table[this] = std::move(table[&other]);
+            table.erase(&other);
+        }
+    }
 }
 
 void Value::copyPayload(const Value& other) {
-    releasePayload();
-    dupPayload(other);
+    if (this == &other) {
+        return;
+    }
+    // Same-representation copies reuse the existing storage instead of the
+    // free-then-allocate rebuild.
+    if (type() == other.type()) {
+        switch (type()) {
+        case nullValue:
+        case intValue:
+        case uintValue:
+        case realValue:
+        case boolValue: {
+            bool hadComments = m_bits.has_comments;
+            bool hadMeta = m_bits.has_meta;
+            m_bits = other.m_bits;
+            m_bits.has_comments = hadComments; // payload copy leaves meta alone
+            m_bits.has_meta = hadMeta;
+            m_strLen = other.m_strLen;
+            m_value = other.m_value;
+            return;
+            }
+
+        case stringValue:
+            // Shorter payloads drop into the existing heap block; the prefix
+            // becomes the new length, so the block only ever shrinks.
+            if (isAllocated()) {
+                unsigned other_len;
+                const char* other_str = other.rawString(&other_len);
+                unsigned capacity = *reinterpret_cast<const unsigned*>(m_value.v_string);
+                if (other_str != nullptr && other_len <= capacity) {
+                    char* dest = m_value.v_string + sizeof(unsigned);
+                    *reinterpret_cast<unsigned*>(m_value.v_string) = other_len;
+                    memmove(dest, other_str, other_len);
+                    dest[other_len] = 0;
+                    m_strLen = other_len;
+                    return;
+                }
+            }
+            break;
+
+        case arrayValue: {
+            // The source may live inside this very container (root =
+            // root["child"]), so copy it out before the assignment starts
+            // destroying our elements.
+            ArrayValues elements(*other.m_value.v_array);
+            *m_value.v_array = std::move(elements);
+            return;
+            }
+
+        case objectValue: {
+            ObjectValues members(*other.m_value.v_map);
+            *m_value.v_map = std::move(members);
+            return;
+            }
+
+        default:
+            break;
+        }
+    }
+    // Type changed: build the replacement before releasing what we hold --
+    // on aliased assignment the source can live inside our own payload. The
+    // temporary walks away with the old payload and releases it.
+    Value replacement;
+    replacement.dupPayload(other);
+    swapPayload(replacement);
 }
 
 void Value::copy(const Value& other) {
+    bool anyMeta = m_bits.has_meta | other.m_bits.has_meta;
     copyPayload(other);
-    dupMeta(other);
+    if (anyMeta) {
+        dupMeta(other);
+    }
 }
 
-ValueType Value::type() const {
-    return static_cast<ValueType>(m_bits.value_type);
+int Value::compareNull(const Value&, const Value&) {
+    return 0;
 }
 
-bool Value::operator<(const Value& other) const {
-    int typeDelta = type() - other.type();
-    if (typeDelta) {
-        return typeDelta < 0;
-    }
-    switch (type()) {
-    case nullValue:
-        return false;
+int Value::compareInt(const Value& a, const Value& b) {
+    return (a.m_value.v_int > b.m_value.v_int) - (a.m_value.v_int < b.m_value.v_int);
+}
 
-    case intValue:
-        return m_value.v_int < other.m_value.v_int;
+int Value::compareUInt(const Value& a, const Value& b) {
+    return (a.m_value.v_uint > b.m_value.v_uint) - (a.m_value.v_uint < b.m_value.v_uint);
+}
 
-    case uintValue:
-        return m_value.v_uint < other.m_value.v_uint;
+int Value::compareReal(const Value& a, const Value& b) {
+    return (a.m_value.v_real > b.m_value.v_real) - (a.m_value.v_real < b.m_value.v_real);
+}
 
-    case realValue:
-        return m_value.v_real < other.m_value.v_real;
+int Value::compareBool(const Value& a, const Value& b) {
+    return static_cast<int>(a.m_value.v_bool) - static_cast<int>(b.m_value.v_bool);
+}
 
-    case boolValue:
-        return m_value.v_bool < other.m_value.v_bool;
+int Value::compareString(const Value& a, const Value& b) {
+    unsigned a_len;
+    unsigned b_len;
+    const char* a_str = a.rawString(&a_len);
+    const char* b_str = b.rawString(&b_len);
+    if ((a_str == nullptr) || (b_str == nullptr)) {
+        return (a_str != nullptr) - (b_str != nullptr);
+    }
+    unsigned min_len = std::min(a_len, b_len);
+    int comp = json_memcmp(a_str, b_str, min_len);
+    if (comp != 0) {
+        return comp;
+    }
+    return (a_len > b_len) - (a_len < b_len);
+}
 
-    case stringValue: {
-        if ((m_value.v_string == nullptr) || (other.m_value.v_string == nullptr)) {
-            return other.m_value.v_string != nullptr;
+int Value::compareArray(const Value& a, const Value& b) {
+    const ArrayValues& av = *a.m_value.v_array;
+    const ArrayValues& bv = *b.m_value.v_array;
+    size_t a_size = av.size();
+    size_t b_size = bv.size();
+    if (a_size != b_size) {
+        return a_size < b_size ? -1 : 1;
+    }
+    for (size_t i = 0; i < a_size; ++i) {
+        int comp = av[i].compare3(bv[i]);
+        if (comp) {
+            return comp;
         }
-        unsigned this_len;
-        unsigned other_len;
-        char const* this_str;
-        char const* other_str;
-        decodePrefixedString(isAllocated(), m_value.v_string, &this_len, &this_str);
-        decodePrefixedString(other.isAllocated(), other.m_value.v_string, &other_len, &other_str);
-        unsigned min_len = std::min(this_len, other_len);
-        JSON_ASSERT(this_str && other_str);
-        int comp = memcmp(this_str, other_str, min_len);
-        if (comp < 0) {
-            return true;
+    }
+    return 0;
+}
+
+int Value::compareObject(const Value& a, const Value& b) {
+    const ObjectValues& am = *a.m_value.v_map;
+    const ObjectValues& bm = *b.m_value.v_map;
+    size_t a_size = am.size();
+    size_t b_size = bm.size();
+    if (a_size != b_size) {
+        return a_size < b_size ? -1 : 1;
+    }
+    ObjectValues::const_iterator ita = am.begin();
+    ObjectValues::const_iterator itb = bm.begin();
+    ObjectValues::const_iterator a_end = am.end();
+    // Entries are contiguous now, so the hardware prefetcher covers the
+    // walk; no manual hints needed.
+    for (; ita != a_end; ++ita, ++itb) {
+        if (ita->first < itb->first) {
+            return -1;
         }
-        if (comp > 0) {
-            return false;
+        if (itb->first < ita->first) {
+            return 1;
         }
-        return this_len < other_len;
+        int comp = ita->second.compare3(itb->second);
+        if (comp) {
+            return comp;
         }
+    }
+    return 0;
+}
 
-    case arrayValue:
-    case objectValue: {
-        size_t this_size = m_value.v_map->size();
-        size_t other_size = other.m_value.v_map->size();
-        if (this_size != other_size) {
-            return this_size < other_size;
-        }
-        return *m_value.v_map < *other.m_value.v_map;
-        }
+// Indexed by ValueType; array and object share the map representation.
+const Value::TypeCompare Value::typeCompare[8] = {
+    &Value::compareNull,      &Value::compareInt,    &Value::compareUInt,
+    &Value::compareReal,      &Value::compareString, &Value::compareBool,
+    &Value::compareArray,     &Value::compareObject,
+};
 
-    default:
-        JSON_ASSERT_MESSAGE(false, "Value::operator<(const Value& other) const unreachable");
+int Value::compare3(const Value& other) const {
+    int typeDelta = type() - other.type();
+    if (typeDelta) {
+        return typeDelta;
     }
-    return false;
+    return typeCompare[m_bits.value_type](*this, other);
+}
+
+bool Value::operator<(const Value& other) const {
+    return compare3(other) < 0;
 }
 
 bool Value::operator<=(const Value& other) const {
@@ -387,61 +602,12 @@ bool Value::operator>(const Value& other) const {
 }
 
 bool Value::operator==(const Value& other) const {
-    if (type() != other.type()) {
+    // Cached string lengths (zero for non-strings): unequal lengths can only
+    // come from unequal values, so reject without touching any payload.
+    if (m_strLen != other.m_strLen) {
         return false;
     }
-    switch (type()) {
-    case nullValue:
-        return true;
-
-    case intValue:
-        return m_value.v_int < other.m_value.v_int;
-
-    case uintValue:
-        return m_value.v_uint < other.m_value.v_uint;
-
-    case realValue:
-        return m_value.v_real < other.m_value.v_real;
-
-    case boolValue:
-        return m_value.v_bool < other.m_value.v_bool;
-
-    case stringValue: {
-        if ((m_value.v_string == nullptr) || (other.m_value.v_string == nullptr)) {
-            return other.m_value.v_string != nullptr;
-        }
-        unsigned this_len;
-        unsigned other_len;
-        char const* this_str;
-        char const* other_str;
-        decodePrefixedString(isAllocated(), m_value.v_string, &this_len, &this_str);
-        decodePrefixedString(other.isAllocated(), other.m_value.v_string, &other_len, &other_str);
-        unsigned min_len = std::min(this_len, other_len);
-        JSON_ASSERT(this_str && other_str);
-        int comp = memcmp(this_str, other_str, min_len);
-        if (comp < 0) {
-            return true;
-        }
-        if (comp > 0) {
-            return false;
-        }
-        return this_len < other_len;
-        }
-
-    case arrayValue:
-    case objectValue: {
-        size_t this_size = m_value.v_map->size();
-        size_t other_size = other.m_value.v_map->size();
-        if (this_size != other_size) {
-            return this_size < other_size;
-        }
-        return *m_value.v_map < *other.m_value.v_map;
-        }
-
-    default:
-        JSON_ASSERT_MESSAGE(false, "Value::operator<(const Value& other) const unreachable");
-    }
-    return false;
+    return compare3(other) == 0;
 }
 
 bool Value::operator!=(const Value& other) const {
@@ -449,25 +615,15 @@ bool Value::operator!=(const Value& other) const {
 }
 
 int Value::compare(const Value& other) const {
-    if (*this < other) {
-        return -1;
-    } else if (*this > other) {
-        return 1;
-    } else {
-        return 0;
-    }
+    int comp = compare3(other);
+    return (comp > 0) - (comp < 0);
 }
 
 const char* Value::asCString() const {
     JSON_ASSERT_MESSAGE(type() == stringValue,
         "in Json::Value::asCString(): requires stringValue");
-    if (m_value.v_string == nullptr) {
-        return nullptr;
-    }
     unsigned this_len;
-    const char* this_str;
-    decodePrefixedString(isAllocated(), m_value.v_string, &this_len, &this_str);
-    return this_str;
+    return rawString(&this_len);
 }
 
 std::string Value::asString() const {
@@ -476,23 +632,28 @@ std::string Value::asString() const {
         return "";
 
     case stringValue: {
-        if (m_value.v_string == nullptr) {
-            return nullptr;
-        }
         unsigned this_len;
-        const char* this_str;
-        decodePrefixedString(isAllocated(), m_value.v_string, &this_len, &this_str);
+        const char* this_str = rawString(&this_len);
+        if (this_str == nullptr) {
+            return "";
+        }
         return std::string(this_str, this_len);
         }
 
     case boolValue:
         return m_value.v_bool ? "true" : "false";
 
-    case intValue:
-        return valueToString(m_value.v_int);
+    // Numeric arms format into a stack buffer through the table-driven
+    // writeTo() fast path and build the result string once.
+    case intValue: {
+        char buffer[24];
+        return std::string(buffer, writeTo(buffer, m_value.v_int));
+        }
 
-    case uintValue:
-        return valueToString(m_value.v_uint);
+    case uintValue: {
+        char buffer[24];
+        return std::string(buffer, writeTo(buffer, m_value.v_uint));
+        }
 
     case realValue:
         return valueToString(m_value.v_real);
@@ -505,21 +666,20 @@ std::string Value::asString() const {
 unsigned Value::getCStringLength() const {
     JSON_ASSERT_MESSAGE(type() == stringValue,
         "in Json::Value::asCString(): requires stringValue");
-    if (m_value.v_string == nullptr) {
-        return 0;
-    }
     unsigned this_len;
-    const char* this_str;
-    decodePrefixedString(isAllocated(), m_value.v_string, &this_len, &this_str);
+    rawString(&this_len);
     return this_len;
 }
 
 bool Value::getString(const char** begin, const char** end) const {
-    if (type() != stringValue || m_value.v_string == nullptr) {
+    if (type() != stringValue) {
         return false;
     }
     unsigned length;
-    decodePrefixedString(isAllocated(), m_value.v_string, &length, begin);
+    *begin = rawString(&length);
+    if (*begin == nullptr) {
+        return false;
+    }
     *end = *begin + length;
     return true;
 }
@@ -684,8 +844,7 @@ bool Value::asBool() const {
         return m_value.v_uint != 0;
 
     case realValue:
-        const int value_classification = std::fpclassify(m_value.v_real);
-        return value_classification != FP_ZERO && value_classification != FP_NAN;
+        return m_bits.real_nonzero;
 
     case nullValue:
         return false;
@@ -698,106 +857,96 @@ bool Value::asBool() const {
     }
 }
 
-bool Value::isNull() const {
-    return type() == nullValue;
-}
-
 bool Value::isBool() const {
     return type() == boolValue;
 }
 
+// Type-class membership as bitmasks indexed by value_type: the class test
+// in each numeric predicate becomes one shift-and-AND instead of a switch,
+// which matters in mixed-type arrays where a per-type jump never predicts.
+// The range checks that remain only run for types actually in the class,
+// with the integer cases hinted as the common ones.
+static constexpr uint32_t kIntegerMask = (1u << intValue) | (1u << uintValue);
+static constexpr uint32_t kNumericMask = kIntegerMask | (1u << realValue);
+
 bool Value::isInt() const {
-    switch (type()) {
-    case intValue:
+    uint32_t bit = 1u << m_bits.value_type;
+    if (!(bit & kNumericMask)) {
+        return false;
+    }
+    if (__builtin_expect((bit & (1u << intValue)) != 0, 1)) {
         return m_value.v_int >= minInt && m_value.v_int <= maxInt;
-
-    case uintValue:
+    }
+    if (bit & (1u << uintValue)) {
         return m_value.v_uint <= uint32_t(maxInt);
-
-    case realValue:
-        return m_value.v_real >= minInt && m_value.v_real <= maxInt && IsIntegral(m_value.v_real);
-
-    default:
-        return false;
     }
+    return m_value.v_real >= minInt && m_value.v_real <= maxInt && IsIntegral(m_value.v_real);
 }
 
 bool Value::isInt64() const {
-    switch (type()) {
-    case intValue:
-        return true;
-
-    case uintValue:
-        return m_value.v_int <= uint64_t(maxInt64);
-
-    case realValue:
-        // Note that maxInt64 (= 2^63 - 1) is not exactly representable as a
-        // double, so double(maxInt64) will be rounded up to 2^63. Therefore we
-        // require the value to be strictly less than the limit.
-        return m_value.v_real >= double(minInt64) && m_value.v_real < double(maxInt64) &&
-            IsIntegral(m_value.v_real);
-
-    default:
+    uint32_t bit = 1u << m_bits.value_type;
+    if (!(bit & kNumericMask)) {
         return false;
     }
+    if (__builtin_expect((bit & (1u << intValue)) != 0, 1)) {
+        return true;
+    }
+    if (bit & (1u << uintValue)) {
+        return m_value.v_uint <= uint64_t(maxInt64);
+    }
+    // Note that maxInt64 (= 2^63 - 1) is not exactly representable as a
+    // double, so double(maxInt64) will be rounded up to 2^63. Therefore we
+    // require the value to be strictly less than the limit.
+    return m_value.v_real >= double(minInt64) && m_value.v_real < double(maxInt64) &&
+        IsIntegral(m_value.v_real);
 }
 
 bool Value::isUInt() const {
-    switch (type()) {
-    case intValue:
-        return m_value.v_int >= 0 && uint64_t(m_value.v_int) <= uint64_t(maxUInt);
-
-    case uintValue:
-        return m_value.v_uint <= maxUInt;
-
-    case realValue:
-        return m_value.v_real >= 0 && m_value.v_real <= maxUInt && IsIntegral(m_value.v_real);
-
-    default:
+    uint32_t bit = 1u << m_bits.value_type;
+    if (!(bit & kNumericMask)) {
         return false;
     }
+    if (__builtin_expect((bit & kIntegerMask) != 0, 1)) {
+        if (bit & (1u << intValue)) {
+            return m_value.v_int >= 0 && uint64_t(m_value.v_int) <= uint64_t(maxUInt);
+        }
+        return m_value.v_uint <= uint32_t(maxUInt);
+    }
+    return m_value.v_real >= 0 && m_value.v_real <= maxUInt && IsIntegral(m_value.v_real);
 }
 
 bool Value::isUInt64() const {
-    switch (type()) {
-    case intValue:
-        return m_value.v_int >= 0;
-
-    case uintValue:
-        return true;
-
-    case realValue:
-        // Note that maxUInt64 (= 2^64 - 1) is not exactly representable as a
-        // double, so double(maxUInt64) will be rounded up to 2^64. Therefore we
-        // require the value to be strictly less than the limit.
-        return m_value.v_real >= 0 && m_value.v_real <= maxUInt64AsDouble &&
-            IsIntegral(m_value.v_real);
-
-    default:
+    uint32_t bit = 1u << m_bits.value_type;
+    if (!(bit & kNumericMask)) {
         return false;
     }
+    if (__builtin_expect((bit & kIntegerMask) != 0, 1)) {
+        return (bit & (1u << uintValue)) || m_value.v_int >= 0;
+    }
+    // Note that maxUInt64 (= 2^64 - 1) is not exactly representable as a
+    // double, so double(maxUInt64) will be rounded up to 2^64. Therefore we
+    // require the value to be strictly less than the limit.
+    return m_value.v_real >= 0 && m_value.v_real <= maxUInt64AsDouble &&
+        IsIntegral(m_value.v_real);
 }
 
 bool Value::isIntegral() const {
-    switch (type()) {
-    case intValue:
-    case uintValue:
+    uint32_t bit = 1u << m_bits.value_type;
+    if (__builtin_expect((bit & kIntegerMask) != 0, 1)) {
         return true;
-
-    case realValue:
-        // Note that maxUInt64 (= 2^64 - 1) is not exactly representable as a
-        // double, so double(maxUInt64) will be rounded up to 2^64. Therefore we
-        // require the value to be strictly less than the limit.
-        return m_value.v_real >= 0 && m_value.v_real <= maxUInt64AsDouble &&
-            IsIntegral(m_value.v_real);
-
-    default:
+    }
+    if (!(bit & kNumericMask)) {
         return false;
     }
+    // Note that maxUInt64 (= 2^64 - 1) is not exactly representable as a
+    // double, so double(maxUInt64) will be rounded up to 2^64. Therefore we
+    // require the value to be strictly less than the limit.
+    return m_value.v_real >= 0 && m_value.v_real <= maxUInt64AsDouble &&
+        IsIntegral(m_value.v_real);
 }
 
 bool Value::isDouble() const {
-    return type() == intValue || type() == uintValue || type() == realValue;
+    return ((1u << m_bits.value_type) & kNumericMask) != 0;
 }
 
 bool Value::isNumeric() const {
@@ -822,7 +971,7 @@ bool Value::isConvertibleTo(ValueType other) const {
         return (isNumeric() && asDouble() == 0.0) ||
             (type() == boolValue && !m_value.v_bool) ||
             (type() == stringValue && asString().empty()) ||
-            (type() == arrayValue && m_value.v_map->empty()) ||
+            (type() == arrayValue && m_value.v_array->empty()) ||
             (type() == objectValue && m_value.v_map->empty()) ||
             type() == nullValue;
 
@@ -867,13 +1016,8 @@ uint32_t Value::size() const {
     case stringValue:
         return 0;
 
-    case arrayValue: // size of the array is highest index + 1
-        if (!m_value.v_map->empty()) {
-            ObjectValues::const_iterator itLast = m_value.v_map->end();
-            --itLast;
-            return (*itLast).first.index() + 1;
-        }
-        return 0;
+    case arrayValue:
+        return uint32_t(m_value.v_array->size());
 
     case objectValue:
         return uint32_t(m_value.v_map->size());
@@ -893,41 +1037,946 @@ bool Value::empty() const {
 
 Value::operator bool() const { return !isNull(); }
 
+void Value::clear() {
+    JSON_ASSERT_MESSAGE(type() == nullValue || type() == arrayValue || type() == objectValue,
+        "in Json::Value::clear(): requires complex value");
+    if (__builtin_expect(m_bits.has_meta, 0)) {
+        std::lock_guard<std::mutex> lock(metaTableMutex);
+        ValueMeta& meta = metaTable()[this];
+        meta.start = 0;
+        meta.length = 0;
+    }
+    switch (type()) {
+    case arrayValue:
+        m_value.v_array->clear();
+        break;
 
+    case objectValue:
+        m_value.v_map->clear();
+        break;
 
-Value::Comments::Comments(const Comments& that) : m_ptr(cloneUnique(that.m_ptr)) {}
-
-Value::Comments::Comments(Comments&& that) noexcept : m_ptr(std::move(that.m_ptr)) {}
+    default:
+        break;
+    }
+}
 
-Value::Comments& Value::Comments::operator=(const Value::Comments& that) {
-    m_ptr = cloneUnique(that.m_ptr);
-    return *this;
+void Value::resize(uint32_t newSize) {
+    JSON_ASSERT_MESSAGE(type() == nullValue || type() == arrayValue,
+        "in Json::Value::resize(): requires arrayValue");
+    if (type() == nullValue) {
+        *this = Value(arrayValue);
+    }
+    m_value.v_array->resize(newSize);
 }
 
-Value::Comments& Value::Comments::operator=(Value::Comments&& that) noexcept {
-    m_ptr = std::move(that.m_ptr);
-    return *this;
+Value& Value::operator[](uint32_t index) {
+    JSON_ASSERT_MESSAGE(type() == nullValue || type() == arrayValue,
+        "in Json::Value::operator[](uint32_t): requires arrayValue");
+    if (type() == nullValue) {
+        *this = Value(arrayValue);
+    }
+    if (index >= m_value.v_array->size()) {
+        m_value.v_array->resize(index + 1);
+    }
+    return (*m_value.v_array)[index];
 }
 
-bool Value::Comments::has(CommentPlacement slot) const {
-    return m_ptr && !(*m_ptr)[slot].empty();
+Value& Value::operator[](int index) {
+    JSON_ASSERT_MESSAGE(index >= 0,
+        "in Json::Value::operator[](int index): index cannot be negative");
+    return (*this)[static_cast<uint32_t>(index)];
 }
 
-std::string Value::Comments::get(CommentPlacement slot) const {
-    if (!m_ptr) {
-        return {};
+const Value& Value::operator[](uint32_t index) const {
+    JSON_ASSERT_MESSAGE(type() == nullValue || type() == arrayValue,
+        "in Json::Value::operator[](uint32_t) const: requires arrayValue");
+    if (type() == nullValue || index >= m_value.v_array->size()) {
+        return nullSingleton();
     }
-    return (*m_ptr)[slot];
+    return (*m_value.v_array)[index];
 }
 
-void Value::Comments::set(CommentPlacement slot, std::string comment) {
-    if (slot >= CommentPlacement::numberOfCommentPlacement) {
-        return;
-    }
-    if (!m_ptr) {
-        m_ptr = std::unique_ptr<Array>(new Array());
+const Value& Value::operator[](int index) const {
+    JSON_ASSERT_MESSAGE(index >= 0,
+        "in Json::Value::operator[](int index) const: index cannot be negative");
+    return (*this)[static_cast<uint32_t>(index)];
+}
+
+Value Value::get(uint32_t index, const Value& defaultValue) const {
+    const Value* value = type() == arrayValue && index < m_value.v_array->size()
+        ? &(*m_value.v_array)[index] : nullptr;
+    return value ? *value : defaultValue;
+}
+
+bool Value::isValidIndex(uint32_t index) const {
+    return index < size();
+}
+
+void Value::shrinkToFit() {
+    if (type() == arrayValue) {
+        m_value.v_array->shrink_to_fit();
+        for (Value& element : *m_value.v_array) {
+            element.shrinkToFit();
+        }
+    } else if (type() == objectValue) {
+        m_value.v_map->shrink_to_fit();
+        for (ObjectValues::value_type& entry : *m_value.v_map) {
+            entry.second.shrinkToFit();
+        }
+    }
+}
+
+Value& Value::append(const Value& value) {
+    return append(Value(value));
+}
+
+Value& Value::append(Value&& value) {
+    JSON_ASSERT_MESSAGE(type() == nullValue || type() == arrayValue,
+        "in Json::Value::append: requires arrayValue");
+    if (type() == nullValue) {
+        *this = Value(arrayValue);
+    }
+    m_value.v_array->push_back(std::move(value));
+    return m_value.v_array->back();
+}
+
+bool Value::insert(uint32_t index, const Value& newValue) {
+    return insert(index, Value(newValue));
+}
+
+bool Value::insert(uint32_t index, Value&& newValue) {
+    JSON_ASSERT_MESSAGE(type() == nullValue || type() == arrayValue,
+        "in Json::Value::insert: requires arrayValue");
+    size_t length = size();
+    if (index > length) {
+        return false;
+    }
+    if (type() == nullValue) {
+        *this = Value(arrayValue);
+    }
+    // One memmove of the 24-byte tail elements; no per-element reindexing.
+    m_value.v_array->insert(m_value.v_array->begin() + index, std::move(newValue));
+    return true;
+}
+
+bool Value::removeIndex(uint32_t index, Value* removed) {
+    if (type() != arrayValue) {
+        return false;
+    }
+    if (index >= m_value.v_array->size()) {
+        return false;
+    }
+    if (removed) {
+        *removed = std::move((*m_value.v_array)[index]);
+    }
+    m_value.v_array->erase(m_value.v_array->begin() + index);
+    return true;
+}
+
+/// @brief Access an object member by name; creates a null member if none
+/// exists. The borrowed-key form backs operator[](StaticString).
+Value& Value::resolveReference(const char* key) {
+    JSON_ASSERT_MESSAGE(type() == nullValue || type() == objectValue,
+        "in Json::Value::resolveReference(): requires objectValue");
+    if (type() == nullValue) {
+        *this = Value(objectValue);
+    }
+    CZString actualKey(key, static_cast<unsigned>(strlen(key)), CZString::noDuplication);
+    return (*m_value.v_map)[actualKey];
+}
+
+Value& Value::resolveReference(const char* key, const char* end) {
+    JSON_ASSERT_MESSAGE(type() == nullValue || type() == objectValue,
+        "in Json::Value::resolveReference(key, end): requires objectValue");
+    if (type() == nullValue) {
+        *this = Value(objectValue);
+    }
+    // The lookup key borrows the caller's bytes; ObjectValues only copies it
+    // (inlining or taking an owned copy of the bytes) if the member has to
+    // be created.
+    CZString actualKey(key, static_cast<unsigned>(end - key), CZString::duplicateOnCopy);
+    return (*m_value.v_map)[actualKey];
+}
+
+Value const* Value::find(char const* begin, char const* end) const {
+    JSON_ASSERT_MESSAGE(isNull() || isObject(),
+        "in Json::Value::find(begin, end): requires objectValue or nullValue");
+    if (isNull()) {
+        return nullptr;
+    }
+    CZString actualKey(begin, static_cast<unsigned>(end - begin), CZString::noDuplication);
+    ObjectValues::const_iterator it = m_value.v_map->find(actualKey);
+    return it == m_value.v_map->end() ? nullptr : &it->second;
+}
+
+Value* Value::demand(char const* begin, char const* end) {
+    JSON_ASSERT_MESSAGE(isNull() || isObject(),
+        "in Json::Value::demand(begin, end): requires objectValue or nullValue");
+    return &resolveReference(begin, end);
+}
+
+Value* Value::demand(StringArena* arena, char const* begin, char const* end) {
+    JSON_ASSERT_MESSAGE(arena != nullptr, "Null arena passed to Value::demand");
+    JSON_ASSERT_MESSAGE(isNull() || isObject(),
+        "in Json::Value::demand(arena, begin, end): requires objectValue or nullValue");
+    if (isNull()) {
+        *this = Value(objectValue);
+    }
+    unsigned length = static_cast<unsigned>(end - begin);
+    // Short keys inline into the CZString word and the empty key ("" is a
+    // valid member name) takes a tiny owned copy; neither needs arena
+    // bytes, and alloc(0) on a fresh arena would hand back null.
+    if (length <= CZString::inlineCapacity) {
+        return &(*m_value.v_map)[CZString(begin, length, CZString::duplicate)];
+    }
+    // Probe with the caller's bytes so repeated keys do not grow the arena;
+    // only a genuinely new key gets a bump-allocated copy, spliced in at
+    // the position the probe already located.
+    CZString probe(begin, length, CZString::noDuplication);
+    ObjectValues::iterator it = m_value.v_map->lower_bound(probe);
+    if (it != m_value.v_map->end() && it->first == probe) {
+        return &it->second;
+    }
+    char* copy = arena->alloc(length);
+    memcpy(copy, begin, length);
+    // The stored key borrows the arena bytes (tagArena): no per-key heap
+    // block while the arena is alive, and the CZString copy ctor takes an
+    // owned copy if the tree is copied out of the arena's lifetime.
+    it = m_value.v_map->insert(it,
+        ObjectValues::value_type(CZString(copy, length, CZString::arenaBorrowed), Value()));
+    return &it->second;
+}
+
+Value Value::get(const char* begin, const char* end, const Value& defaultValue) const {
+    const Value* found = find(begin, end);
+    return found ? *found : defaultValue;
+}
+
+Value Value::get(const char* key, const Value& defaultValue) const {
+    return get(key, key + strlen(key), defaultValue);
+}
+
+Value Value::get(const std::string& key, const Value& defaultValue) const {
+    return get(key.data(), key.data() + key.length(), defaultValue);
+}
+
+bool Value::removeMember(const char* begin, const char* end, Value* removed) {
+    if (type() != objectValue) {
+        return false;
+    }
+    CZString actualKey(begin, static_cast<unsigned>(end - begin), CZString::noDuplication);
+    ObjectValues::iterator it = m_value.v_map->find(actualKey);
+    if (it == m_value.v_map->end()) {
+        return false;
+    }
+    if (removed) {
+        *removed = std::move(it->second);
+    }
+    m_value.v_map->erase(it);
+    return true;
+}
+
+bool Value::removeMember(const char* key, Value* removed) {
+    return removeMember(key, key + strlen(key), removed);
+}
+
+bool Value::removeMember(const std::string& key, Value* removed) {
+    return removeMember(key.data(), key.data() + key.length(), removed);
+}
+
+void Value::removeMember(const char* key) {
+    JSON_ASSERT_MESSAGE(type() == nullValue || type() == objectValue,
+        "in Json::Value::removeMember(): requires objectValue");
+    if (type() == nullValue) {
+        return;
+    }
+    removeMember(key, key + strlen(key), nullptr);
+}
+
+void Value::removeMember(const std::string& key) {
+    removeMember(key.c_str());
+}
+
+bool Value::isMember(const char* begin, const char* end) const {
+    return find(begin, end) != nullptr;
+}
+
+bool Value::isMember(const char* key) const {
+    return isMember(key, key + strlen(key));
+}
+
+bool Value::isMember(const std::string& key) const {
+    return isMember(key.data(), key.data() + key.length());
+}
+
+std::vector<std::string> Value::getMemberNames() const {
+    JSON_ASSERT_MESSAGE(type() == nullValue || type() == objectValue,
+        "in Json::Value::getMemberNames(), value must be objectValue");
+    if (type() == nullValue) {
+        return std::vector<std::string>();
+    }
+    std::vector<std::string> members;
+    members.reserve(m_value.v_map->size());
+    ObjectValues::const_iterator it = m_value.v_map->begin();
+    ObjectValues::const_iterator itEnd = m_value.v_map->end();
+    for (; it != itEnd; ++it) {
+        members.push_back(std::string(it->first.data(), it->first.length()));
+    }
+    return members;
+}
+
+/// @brief Store a string payload: in the union when it fits (terminator
+/// included), otherwise in a length-prefixed heap block.
+void Value::storeString(const char* str, unsigned int length) {
+    if (length < sizeof(m_value.v_sbuf)) {
+        initBasic(stringValue);
+        m_bits.inline_str = 1;
+        m_bits.inline_len = length & 15;
+        memset(m_value.v_sbuf, 0, sizeof(m_value.v_sbuf));
+        memcpy(m_value.v_sbuf, str, length);
+    } else {
+        initBasic(stringValue, true);
+        m_value.v_string = duplicateAndPrefixStringValue(str, length);
+    }
+    m_strLen = length;
+}
+
+/// @brief Decode any of the three string representations (inline, prefixed
+/// heap block, borrowed static) into pointer + length.
+const char* Value::rawString(unsigned int* length) const {
+    *length = m_strLen;
+    if (m_bits.inline_str) {
+        return m_value.v_sbuf;
+    }
+    if (m_value.v_string == nullptr) {
+        return nullptr;
+    }
+    // The cached length makes the prefix load unnecessary; just skip over it.
+    if (isAllocated() || m_bits.arena_str) {
+        return m_value.v_string + sizeof(unsigned);
+    }
+    return m_value.v_string;
+}
+
+void Value::dupPayload(const Value& other) {
+    setType(other.type());
+    setIsAllocated(false);
+    m_bits.inline_str = other.m_bits.inline_str;
+    m_bits.inline_len = other.m_bits.inline_len;
+    m_bits.arena_str = 0;
+    m_bits.real_nonzero = other.m_bits.real_nonzero;
+    m_strLen = other.m_strLen;
+    switch (type()) {
+    case nullValue:
+    case intValue:
+    case uintValue:
+    case realValue:
+    case boolValue:
+        m_value = other.m_value;
+        break;
+
+    case stringValue:
+        if (other.isAllocated() || other.m_bits.arena_str) {
+            // A copy may outlive the source arena, so it owns heap storage.
+            unsigned len;
+            const char* str;
+            decodePrefixedString(other.m_value.v_string, &len, &str);
+            m_value.v_string = duplicateAndPrefixStringValue(str, len);
+            setIsAllocated(true);
+        } else {
+            // Inline payload or borrowed static string: a plain union copy.
+            m_value = other.m_value;
+        }
+        break;
+
+    case arrayValue:
+        m_value.v_array = new ArrayValues(*other.m_value.v_array);
+        break;
+
+    case objectValue:
+        m_value.v_map = new ObjectValues(*other.m_value.v_map);
+        break;
+
+    default:
+        JSON_ASSERT_MESSAGE(false, "Value::dupPayload unreachable");
+    }
+}
+
+void Value::releasePayload() {
+    switch (type()) {
+    case stringValue:
+        if (isAllocated()) {
+            delete[] m_value.v_string;
+        }
+        break;
+
+    case arrayValue:
+        delete m_value.v_array;
+        break;
+
+    case objectValue:
+        delete m_value.v_map;
+        break;
+
+    default:
+        break;
+    }
+}
+
+void Value::dupMeta(const Value& other) {
+    std::lock_guard<std::mutex> lock(metaTableMutex);
+    std::unordered_map<const Value*, ValueMeta>& table = metaTable();
+    if (other.m_bits.has_meta) {
+        table[this] = table[&other];
+    } else if (m_bits.has_meta) {
+        table.erase(this);
+    }
+    m_bits.has_meta = other.m_bits.has_meta;
+    m_bits.has_comments = other.m_bits.has_comments;
+}
+
+
+
+constexpr uint32_t Value::Comments::noComment;
+
+// Blob header accessors. Layout: numberOfCommentPlacement slot offsets
+// followed by the end offset, all uint32_t, then the concatenated bytes.
+static inline const uint32_t* blobOffsets(const char* blob) {
+    return reinterpret_cast<const uint32_t*>(blob);
+}
+
+static inline const char* blobData(const char* blob) {
+    return blob + (numberOfCommentPlacement + 1) * sizeof(uint32_t);
+}
+
+// A set slot's bytes run from its offset to the next set slot's offset.
+static inline uint32_t blobSlotEnd(const char* blob, int slot) {
+    const uint32_t* off = blobOffsets(blob);
+    for (int next = slot + 1; next < numberOfCommentPlacement; ++next) {
+        if (off[next] != uint32_t(-1)) {
+            return off[next];
+        }
+    }
+    return off[numberOfCommentPlacement];
+}
+
+static char* duplicateBlob(const char* blob) {
+    if (!blob) {
+        return nullptr;
+    }
+    size_t header = (numberOfCommentPlacement + 1) * sizeof(uint32_t);
+    size_t size = header + blobOffsets(blob)[numberOfCommentPlacement];
+    char* copy = new char[size];
+    memcpy(copy, blob, size);
+    return copy;
+}
+
+Value::Comments::Comments(const Comments& that) : m_blob(duplicateBlob(that.m_blob)) {}
+
+Value::Comments::~Comments() {
+    delete[] m_blob;
+}
+
+Value::Comments& Value::Comments::operator=(const Value::Comments& that) {
+    if (this != &that) {
+        delete[] m_blob;
+        m_blob = duplicateBlob(that.m_blob);
+    }
+    return *this;
+}
+
+Value::Comments& Value::Comments::operator=(Value::Comments&& that) noexcept {
+    if (this != &that) {
+        delete[] m_blob;
+        m_blob = that.m_blob;
+        that.m_blob = nullptr;
+    }
+    return *this;
+}
+
+bool Value::Comments::has(CommentPlacement slot) const {
+    return m_blob && slot < numberOfCommentPlacement && blobOffsets(m_blob)[slot] != noComment;
+}
+
+std::string Value::Comments::get(CommentPlacement slot) const {
+    if (!has(slot)) {
+        return {};
+    }
+    uint32_t begin = blobOffsets(m_blob)[slot];
+    return std::string(blobData(m_blob) + begin, blobSlotEnd(m_blob, slot) - begin);
+}
+
+void Value::Comments::set(CommentPlacement slot, const char* comment, uint32_t length) {
+    if (slot >= CommentPlacement::numberOfCommentPlacement) {
+        return;
+    }
+    // Gather the surviving slots, then rebuild the block in one pass.
+    const char* pieces[numberOfCommentPlacement];
+    uint32_t lengths[numberOfCommentPlacement];
+    for (int i = 0; i < numberOfCommentPlacement; ++i) {
+        if (i == slot) {
+            // An empty comment clears the slot, matching the previous
+            // empty-string-means-absent behavior.
+            pieces[i] = length == 0 ? nullptr : comment;
+            lengths[i] = length;
+        } else if (has(static_cast<CommentPlacement>(i))) {
+            uint32_t begin = blobOffsets(m_blob)[i];
+            pieces[i] = blobData(m_blob) + begin;
+            lengths[i] = blobSlotEnd(m_blob, i) - begin;
+        } else {
+            pieces[i] = nullptr;
+            lengths[i] = 0;
+        }
+    }
+    size_t header = (numberOfCommentPlacement + 1) * sizeof(uint32_t);
+    size_t total = 0;
+    for (int i = 0; i < numberOfCommentPlacement; ++i) {
+        if (pieces[i]) {
+            total += lengths[i];
+        }
+    }
+    char* blob = new char[header + total];
+    uint32_t* off = reinterpret_cast<uint32_t*>(blob);
+    char* data = blob + header;
+    uint32_t cursor = 0;
+    for (int i = 0; i < numberOfCommentPlacement; ++i) {
+        if (pieces[i]) {
+            off[i] = cursor;
+            memcpy(data + cursor, pieces[i], lengths[i]);
+            cursor += lengths[i];
+        } else {
+            off[i] = noComment;
+        }
+    }
+    off[numberOfCommentPlacement] = cursor;
+    delete[] m_blob;
+    m_blob = blob;
+}
+
+std::unordered_map<const Value*, Value::ValueMeta>& Value::metaTable() {
+    // Process-wide, guarded by metaTableMutex at every call site: a tree
+    // parsed on a worker thread keeps its comments and offsets wherever it
+    // is consumed, and a Value destroyed off-thread erases its own entry.
+    static std::unordered_map<const Value*, ValueMeta> table;
+    return table;
+}
+
+void Value::setComment(const char* comment, size_t length, CommentPlacement placement) {
+    if (length != 0 && comment[length - 1] == '\n') {
+        --length;
+    }
+    JSON_ASSERT_MESSAGE(length == 0 || comment[0] == '/',
+        "in Json::Value::setComment(): Comments must start with /");
+    {
+        std::lock_guard<std::mutex> lock(metaTableMutex);
+        metaTable()[this].comments.set(placement, comment, static_cast<uint32_t>(length));
+    }
+    m_bits.has_comments = 1;
+    m_bits.has_meta = 1;
+}
+
+bool Value::hasComment(CommentPlacement placement) const {
+    if (!m_bits.has_comments) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(metaTableMutex);
+    const std::unordered_map<const Value*, ValueMeta>& table = metaTable();
+    std::unordered_map<const Value*, ValueMeta>::const_iterator it = table.find(this);
+    return it != table.end() && it->second.comments.has(placement);
+}
+
+void Value::setOffsetStart(ptrdiff_t start) {
+    std::lock_guard<std::mutex> lock(metaTableMutex);
+    ValueMeta& meta = metaTable()[this];
+    // Setting the start rebases the stored length so an already-set limit
+    // keeps its meaning; readers set start first, then limit.
+    ptrdiff_t limit = meta.start + static_cast<ptrdiff_t>(meta.length);
+    meta.start = static_cast<decltype(meta.start)>(start);
+    meta.length = limit > start ? static_cast<decltype(meta.length)>(limit - start) : 0;
+    m_bits.has_meta = 1;
+}
+
+void Value::setOffsetLimit(ptrdiff_t limit) {
+    std::lock_guard<std::mutex> lock(metaTableMutex);
+    ValueMeta& meta = metaTable()[this];
+    meta.length = limit > meta.start ? static_cast<decltype(meta.length)>(limit - meta.start) : 0;
+    m_bits.has_meta = 1;
+}
+
+ptrdiff_t Value::getOffsetStart() const {
+    if (!m_bits.has_meta) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(metaTableMutex);
+    const std::unordered_map<const Value*, ValueMeta>& table = metaTable();
+    std::unordered_map<const Value*, ValueMeta>::const_iterator it = table.find(this);
+    return it != table.end() ? it->second.start : 0;
+}
+
+ptrdiff_t Value::getOffsetLimit() const {
+    if (!m_bits.has_meta) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(metaTableMutex);
+    const std::unordered_map<const Value*, ValueMeta>& table = metaTable();
+    std::unordered_map<const Value*, ValueMeta>::const_iterator it = table.find(this);
+    return it != table.end() ? it->second.start + static_cast<ptrdiff_t>(it->second.length) : 0;
+}
+
+std::string Value::getComment(CommentPlacement placement) const {
+    if (!m_bits.has_comments) {
+        return {};
+    }
+    std::lock_guard<std::mutex> lock(metaTableMutex);
+    const std::unordered_map<const Value*, ValueMeta>& table = metaTable();
+    std::unordered_map<const Value*, ValueMeta>::const_iterator it = table.find(this);
+    return it != table.end() ? it->second.comments.get(placement) : std::string();
+}
+
+// The key/name accessors build std::string or Value results, so they stay
+// out of line; the per-element hot operations are inline in the header.
+Value ValueIteratorBase::key() const {
+    if (m_kind == kindArray) {
+        return Value(m_index);
+    }
+    if (m_kind == kindObject) {
+        const char* str = m_object->first.data();
+        if (str) {
+            return Value(str, m_object->first.length());
+        }
+        return Value(m_object->first.index());
+    }
+    return Value();
+}
+
+uint32_t ValueIteratorBase::index() const {
+    if (m_kind == kindArray) {
+        return m_index;
+    }
+    if (m_kind == kindObject && m_object->first.data() == nullptr) {
+        return m_object->first.index();
+    }
+    return Value::maxUInt;
+}
+
+std::string ValueIteratorBase::name() const {
+    if (m_kind != kindObject) {
+        return {};
+    }
+    const char* str = m_object->first.data();
+    return str ? std::string(str, m_object->first.length()) : std::string();
+}
+
+char const* ValueIteratorBase::memberName(char const** end) const {
+    const char* str = m_kind == kindObject ? m_object->first.data() : nullptr;
+    if (!str) {
+        *end = nullptr;
+        return "";
+    }
+    *end = str + m_object->first.length();
+    return str;
+}
+
+ValueConstIterator::ValueConstIterator() = default;
+
+ValueConstIterator::ValueConstIterator(ValueIterator const& other) : ValueIteratorBase(other) {}
+
+ValueConstIterator& ValueConstIterator::operator=(const ValueIteratorBase& other) {
+    copy(other);
+    return *this;
+}
+
+ValueIterator::ValueIterator() = default;
+
+ValueIterator::ValueIterator(const ValueIterator& other) = default;
+
+ValueIterator::ValueIterator(const ValueConstIterator& other) : ValueIteratorBase(other) {
+    throwRuntimeError("ConstIterator to Iterator should never be allowed.");
+}
+
+ValueIterator& ValueIterator::operator=(const ValueIterator& other) {
+    copy(other);
+    return *this;
+}
+
+ValueConstIterator Value::begin() const {
+    switch (type()) {
+    case arrayValue:
+        return ValueConstIterator(m_value.v_array->begin(), 0);
+
+    case objectValue:
+        return ValueConstIterator(m_value.v_map->begin());
+
+    default:
+        return ValueConstIterator();
+    }
+}
+
+ValueConstIterator Value::end() const {
+    switch (type()) {
+    case arrayValue:
+        return ValueConstIterator(m_value.v_array->end(), uint32_t(m_value.v_array->size()));
+
+    case objectValue:
+        return ValueConstIterator(m_value.v_map->end());
+
+    default:
+        return ValueConstIterator();
+    }
+}
+
+ValueIterator Value::begin() {
+    switch (type()) {
+    case arrayValue:
+        return ValueIterator(m_value.v_array->begin(), 0);
+
+    case objectValue:
+        return ValueIterator(m_value.v_map->begin());
+
+    default:
+        return ValueIterator();
+    }
+}
+
+ValueIterator Value::end() {
+    switch (type()) {
+    case arrayValue:
+        return ValueIterator(m_value.v_array->end(), uint32_t(m_value.v_array->size()));
+
+    case objectValue:
+        return ValueIterator(m_value.v_map->end());
+
+    default:
+        return ValueIterator();
+    }
+}
+
+SmallStr::SmallStr(const char* str, size_t length, bool borrow)
+    : m_length(static_cast<uint32_t>(length)) {
+    if (borrow) {
+        m_mode = modeBorrowed;
+        m_ptr = str;
+        return;
+    }
+    if (length < sizeof(m_buf)) {
+        m_mode = modeInline;
+        memcpy(m_buf, str, length);
+        m_buf[length] = '\0';
+        return;
+    }
+    char* copy = new char[length + 1];
+    memcpy(copy, str, length);
+    copy[length] = '\0';
+    m_mode = modeOwned;
+    m_ptr = copy;
+}
+
+SmallStr::SmallStr(const SmallStr& other) : m_length(other.m_length), m_mode(other.m_mode) {
+    if (other.m_mode == modeOwned) {
+        char* copy = new char[m_length + 1];
+        memcpy(copy, other.m_ptr, m_length + 1);
+        m_ptr = copy;
+    } else {
+        // Covers both the inline bytes and the borrowed pointer.
+        memcpy(m_buf, other.m_buf, sizeof(m_buf));
+    }
+}
+
+SmallStr::SmallStr(SmallStr&& other) noexcept : m_length(other.m_length), m_mode(other.m_mode) {
+    memcpy(m_buf, other.m_buf, sizeof(m_buf));
+    other.m_length = 0;
+    other.m_mode = modeInline;
+    other.m_buf[0] = '\0';
+}
+
+SmallStr::~SmallStr() {
+    if (m_mode == modeOwned) {
+        delete[] const_cast<char*>(m_ptr);
+    }
+}
+
+SmallStr& SmallStr::operator=(const SmallStr& other) {
+    if (this != &other) {
+        SmallStr copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+SmallStr& SmallStr::operator=(SmallStr&& other) noexcept {
+    if (this != &other) {
+        if (m_mode == modeOwned) {
+            delete[] const_cast<char*>(m_ptr);
+        }
+        m_length = other.m_length;
+        m_mode = other.m_mode;
+        memcpy(m_buf, other.m_buf, sizeof(m_buf));
+        other.m_length = 0;
+        other.m_mode = modeInline;
+        other.m_buf[0] = '\0';
+    }
+    return *this;
+}
+
+PathArgument::PathArgument() : m_index(0) {}
+
+PathArgument::PathArgument(uint32_t index) : m_index(index), kind_(kindIndex) {}
+
+// C-string keys are almost always literals; borrow them instead of copying.
+PathArgument::PathArgument(const char* key) : kind_(kindKey) {
+    new (&m_key) SmallStr(key, strlen(key), true);
+}
+
+PathArgument::PathArgument(const std::string& key) : kind_(kindKey) {
+    new (&m_key) SmallStr(key.data(), key.size(), false);
+}
+
+PathArgument::PathArgument(const PathArgument& other) : kind_(other.kind_) {
+    if (kind_ == kindKey) {
+        new (&m_key) SmallStr(other.m_key);
+    } else {
+        m_index = other.m_index;
+    }
+}
+
+PathArgument::PathArgument(PathArgument&& other) noexcept : kind_(other.kind_) {
+    if (kind_ == kindKey) {
+        new (&m_key) SmallStr(std::move(other.m_key));
+    } else {
+        m_index = other.m_index;
+    }
+}
+
+PathArgument::~PathArgument() {
+    if (kind_ == kindKey) {
+        m_key.~SmallStr();
+    }
+}
+
+PathArgument& PathArgument::operator=(const PathArgument& other) {
+    if (this != &other) {
+        this->~PathArgument();
+        new (this) PathArgument(other);
+    }
+    return *this;
+}
+
+PathArgument& PathArgument::operator=(PathArgument&& other) noexcept {
+    if (this != &other) {
+        this->~PathArgument();
+        new (this) PathArgument(std::move(other));
+    }
+    return *this;
+}
+
+Path::Path(const std::string& path, const PathArgument& a1, const PathArgument& a2,
+           const PathArgument& a3, const PathArgument& a4, const PathArgument& a5) {
+    InArgs in;
+    in.reserve(5);
+    in.push_back(&a1);
+    in.push_back(&a2);
+    in.push_back(&a3);
+    in.push_back(&a4);
+    in.push_back(&a5);
+    makePath(path, in);
+}
+
+void Path::makePath(const std::string& path, const InArgs& in) {
+    const char* current = path.c_str();
+    const char* end = current + path.length();
+    InArgs::const_iterator itInArg = in.begin();
+    while (current != end) {
+        if (*current == '[') {
+            ++current;
+            if (current != end && *current == '%') {
+                addPathInArg(path, in, itInArg, PathArgument::kindIndex);
+                ++current;
+            } else {
+                uint32_t index = 0;
+                for (; current != end && *current >= '0' && *current <= '9'; ++current) {
+                    index = index * 10 + static_cast<uint32_t>(*current - '0');
+                }
+                m_args.push_back(PathArgument(index));
+            }
+            if (current == end || *current++ != ']') {
+                invalidPath(path, static_cast<int>(current - path.c_str()));
+            }
+        } else if (*current == '%') {
+            addPathInArg(path, in, itInArg, PathArgument::kindKey);
+            ++current;
+        } else if (*current == '.' || *current == ']') {
+            ++current;
+        } else {
+            const char* beginName = current;
+            while (current != end && *current != '[' && *current != '.') {
+                ++current;
+            }
+            m_args.push_back(PathArgument(std::string(beginName, current)));
+        }
+    }
+}
+
+void Path::addPathInArg(const std::string& path, const InArgs& in,
+                        InArgs::const_iterator& itInArg, PathArgument::Kind kind) {
+    if (itInArg == in.end()) {
+        throwLogicError("in Json::Path::Path(): missing '%' argument for path \"" + path + "\"");
+    }
+    if ((*itInArg)->kind_ != kind) {
+        throwLogicError("in Json::Path::Path(): '%' argument has wrong kind in path \"" + path + "\"");
+    }
+    m_args.push_back(**itInArg++);
+}
+
+void Path::invalidPath(const std::string& path, int location) {
+    throwLogicError("in Json::Path::Path(): invalid path \"" + path + "\" near position " +
+        std::to_string(location));
+}
+
+const Value& Path::resolve(const Value& root) const {
+    const Value* node = &root;
+    for (const PathArgument& arg : m_args) {
+        if (arg.kind_ == PathArgument::kindIndex) {
+            if (!node->isArray() || !node->isValidIndex(arg.m_index)) {
+                return Value::nullSingleton();
+            }
+            node = &((*node)[arg.m_index]);
+        } else if (arg.kind_ == PathArgument::kindKey) {
+            if (!node->isObject()) {
+                return Value::nullSingleton();
+            }
+            // The compiled key carries its length, so each step is a direct
+            // find with no strlen.
+            const char* key = arg.m_key.c_str();
+            const Value* found = node->find(key, key + arg.m_key.length());
+            if (!found) {
+                return Value::nullSingleton();
+            }
+            node = found;
+        }
+    }
+    return *node;
+}
+
+Value Path::resolve(const Value& root, const Value& defaultValue) const {
+    const Value& found = resolve(root);
+    return &found == &Value::nullSingleton() ? defaultValue : found;
+}
+
+Value& Path::make(Value& root) const {
+    Value* node = &root;
+    for (const PathArgument& arg : m_args) {
+        if (arg.kind_ == PathArgument::kindIndex) {
+            JSON_ASSERT_MESSAGE(node->isNull() || node->isArray(),
+                "in Json::Path::make(): path steps into a non-array value with an index");
+            node = &((*node)[arg.m_index]);
+        } else if (arg.kind_ == PathArgument::kindKey) {
+            JSON_ASSERT_MESSAGE(node->isNull() || node->isObject(),
+                "in Json::Path::make(): path steps into a non-object value with a key");
+            const char* key = arg.m_key.c_str();
+            node = node->demand(key, key + arg.m_key.length());
+        }
     }
-    (*m_ptr)[slot] = std::move(comment);
+    return *node;
 }
 
 
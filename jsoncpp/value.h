@@ -1,9 +1,14 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
 #include <cstdint>
-#include <map>
-#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
+#include "precision.h"
 
 namespace JsonCPP {
 /// @brief Type of the value held by a Value object.
@@ -25,23 +30,25 @@ enum CommentPlacement {
     numberOfCommentPlacement
 };
 
-/// @brief Type of precision for formatting of real values.
-enum PrecisionType {
-    significantDigits = 0,  // we set max number of significant digits in string
-    decimalPlaces           // we set max number of digits after "." in string
-};
-
 class StaticString {
 public:
-    explicit StaticString(const char* string) : m_str(string) {}
+    // __builtin_strlen folds to a constant for literals, so wrapping a
+    // literal costs nothing and the length never has to be rescanned.
+    explicit constexpr StaticString(const char* string)
+        : m_str(string), m_len(__builtin_strlen(string)) {}
+    constexpr StaticString(const char* string, size_t length)
+        : m_str(string), m_len(length) {}
 
-    const char* operator()() const { return m_str; }
-    const char* c_str() const { return m_str; }
+    constexpr const char* operator()() const { return m_str; }
+    constexpr const char* c_str() const { return m_str; }
+    constexpr size_t length() const { return m_len; }
 
 private:
     const char* m_str;
+    size_t m_len;
 };
 
+class StringArena;
 class ValueConstIterator;
 class ValueIterator;
 
@@ -50,19 +57,25 @@ public:
     static Value const& nullSingleton();
     static constexpr int64_t minInt64 = int64_t(~(uint64_t(-1) / 2));
     static constexpr int64_t maxInt64 = int64_t(uint64_t(-1) / 2);
-    static constexpr int64_t maxUInt64 = uint64_t(-1);
+    static constexpr uint64_t maxUInt64 = uint64_t(-1);
 
     static constexpr int32_t minInt = int32_t(~(uint32_t(-1) / 2));
     static constexpr int32_t maxInt = int32_t(uint32_t(-1) / 2);
-    static constexpr int32_t maxUInt = uint32_t(-1);
+    static constexpr uint32_t maxUInt = uint32_t(-1);
 
-    static constexpr uint32_t defaultRealPrecision = 17;
+    static constexpr uint32_t defaultRealPrecision = JsonCPP::defaultRealPrecision;
     static constexpr double maxUInt64AsDouble = 18446744073709551615.0;
 
 private:
     class CZString {
     public:
-        enum DuplicationPolicy { noDuplication = 0, duplicate, duplicateOnCopy };
+        enum DuplicationPolicy {
+            noDuplication = 0,
+            duplicate,
+            duplicateOnCopy,
+            inlined,
+            arenaBorrowed // bytes live in a StringArena the caller owns
+        };
         CZString(uint32_t index);
         CZString(char const* str, unsigned int length, DuplicationPolicy allocate);
         CZString(CZString const& other);
@@ -80,20 +93,151 @@ private:
     private:
         void swap(CZString& other);
 
-        struct StringStorage {
-            unsigned int policy : 2;
-            unsigned int length : 30; // 1GB max
+        // One tagged 8-byte word, so a map node carries half the key it used
+        // to. Layout (little-endian x86-64, 48-bit user addresses):
+        //   [63:61] tag   [60:48] length   [47:0] pointer
+        // tagInline keys store their bytes in m_bytes[0..5] with the length
+        // folded into the metadata bits; keys longer than the 13-bit length
+        // field are copied into an owned length-prefixed block (tagPrefixed).
+        enum Tag {
+            tagIndex = 0,   // array-style key; index in the low 32 bits
+            tagBorrowed,    // static or caller-owned string, never freed here
+            tagDupOnCopy,   // transient lookup key; copying it duplicates
+            tagInline,      // up to 6 key bytes stored in place
+            tagPrefixed,    // owned heap block with a length prefix
+            tagArena        // borrowed arena bytes; copying takes an owned copy
         };
+    public:
+        static constexpr unsigned inlineCapacity = 6;
+
+    private:
+        static constexpr unsigned tagShift = 61;
+        static constexpr unsigned lenShift = 48;
+        static constexpr uint64_t lenMask = (uint64_t(1) << 13) - 1;
+        static constexpr uint64_t ptrMask = (uint64_t(1) << lenShift) - 1;
+
+        Tag tag() const { return static_cast<Tag>(m_word >> tagShift); }
+        void storeInline(const char* str, unsigned int length);
+        const char* pointer() const {
+            return reinterpret_cast<const char*>(m_word & ptrMask);
+        }
+        static uint64_t pack(Tag tag, unsigned length, const void* ptr) {
+            return (uint64_t(tag) << tagShift) |
+                   (uint64_t(length & lenMask) << lenShift) |
+                   (reinterpret_cast<uintptr_t>(ptr) & ptrMask);
+        }
 
-        char const* m_cstr; // actually, a prefixed string, unless policy is noDup
         union {
-            uint32_t m_index;
-            StringStorage m_storage;
+            uint64_t m_word;
+            char m_bytes[sizeof(uint64_t)];
         };
     };
 
 public:
-    typedef std::map<CZString, Value> ObjectValues;
+    // Flat, ordered object storage. Members live contiguously in key order:
+    // lookup is a binary search over one allocation instead of a pointer
+    // chase through tree nodes, iteration is linear memory, and the ordered
+    // guarantees of getMemberNames()/compare3() are preserved -- which is
+    // why this is a sorted vector rather than the open-addressed hash table
+    // it replaced std::map in favor of. The tradeoff: inserting a member
+    // may move its siblings, so references and iterators into an object are
+    // only stable until the next insert/removal on that same object.
+    class ObjectValues {
+    public:
+        typedef std::pair<CZString, Value> value_type;
+        typedef std::vector<value_type> Entries;
+        typedef Entries::iterator iterator;
+        typedef Entries::const_iterator const_iterator;
+
+        size_t size() const { return m_entries.size(); }
+        bool empty() const { return m_entries.empty(); }
+        void clear() { m_entries.clear(); }
+        void shrink_to_fit() { m_entries.shrink_to_fit(); }
+
+        iterator begin() { return m_entries.begin(); }
+        iterator end() { return m_entries.end(); }
+        const_iterator begin() const { return m_entries.begin(); }
+        const_iterator end() const { return m_entries.end(); }
+
+        // Most objects in real documents have a handful of members; at that
+        // size the whole entry array is a cache line or two and a forward
+        // scan with predictable branches beats binary search's data-dependent
+        // jumps. Larger objects fall through to std::lower_bound.
+        iterator lower_bound(const CZString& key) {
+            if (m_entries.size() <= linearScanMax) {
+                iterator it = m_entries.begin();
+                iterator last = m_entries.end();
+                while (it != last && it->first < key) {
+                    ++it;
+                }
+                return it;
+            }
+            return std::lower_bound(m_entries.begin(), m_entries.end(), key, KeyLess());
+        }
+        const_iterator lower_bound(const CZString& key) const {
+            if (m_entries.size() <= linearScanMax) {
+                const_iterator it = m_entries.begin();
+                const_iterator last = m_entries.end();
+                while (it != last && it->first < key) {
+                    ++it;
+                }
+                return it;
+            }
+            return std::lower_bound(m_entries.begin(), m_entries.end(), key, KeyLess());
+        }
+
+        iterator find(const CZString& key) {
+            iterator it = lower_bound(key);
+            return it != m_entries.end() && it->first == key ? it : m_entries.end();
+        }
+        const_iterator find(const CZString& key) const {
+            const_iterator it = lower_bound(key);
+            return it != m_entries.end() && it->first == key ? it : m_entries.end();
+        }
+
+        /// Insert-if-absent, like the map subscript this replaces.
+        Value& operator[](const CZString& key) {
+            iterator it = lower_bound(key);
+            if (it != m_entries.end() && it->first == key) {
+                return it->second;
+            }
+            it = m_entries.insert(it, value_type(key, Value()));
+            return it->second;
+        }
+
+        /// Splice a new entry in at the position lower_bound returned;
+        /// the caller guarantees ordering. The entry is moved, so keys
+        /// whose stored form is already persistent (inline, owned,
+        /// arena-borrowed) are not re-copied on the way in.
+        iterator insert(iterator pos, value_type&& entry) {
+            return m_entries.insert(pos, std::move(entry));
+        }
+
+        iterator erase(iterator pos) { return m_entries.erase(pos); }
+        size_t erase(const CZString& key) {
+            iterator it = find(key);
+            if (it == m_entries.end()) {
+                return 0;
+            }
+            m_entries.erase(it);
+            return 1;
+        }
+
+    private:
+        static constexpr size_t linearScanMax = 8;
+
+        struct KeyLess {
+            bool operator()(const value_type& entry, const CZString& key) const {
+                return entry.first < key;
+            }
+        };
+
+        Entries m_entries;
+    };
+    // Arrays are dense by construction, so they live in a contiguous vector
+    // rather than paying a map node (and an integer-keyed CZString) per
+    // element.
+    typedef std::vector<Value> ArrayValues;
 
     Value(ValueType type = nullValue);
     Value(int32_t value);
@@ -102,7 +246,13 @@ public:
     Value(uint64_t value);
     Value(double value);
     Value(const char* value); // Copy til first 0. (NULL causes to seg-fault.)
+    // Known-length form for callers that already measured the bytes (the
+    // lexer always has); skips the strlen re-scan of the overload above.
+    Value(const char* value, size_t length);
     Value(const char* begin, const char* end); // Copy all, includ zeroes.
+    // Copy into arena storage: the bytes are freed with the arena, not per
+    // value. For a parser that builds a whole document from one pool.
+    Value(StringArena* arena, const char* begin, const char* end);
     Value(const StaticString& value);
     Value(const std::string& value);
     Value(bool value);
@@ -132,6 +282,10 @@ public:
     bool operator==(const Value& other) const;
     bool operator!=(const Value& other) const;
     int compare(const Value& other) const;
+    /// Three-way comparison: negative, zero or positive. Values of different
+    /// types order by type tag. operator<, operator== and compare() are all
+    /// thin wrappers over this, so each comparison runs the arms exactly once.
+    int compare3(const Value& other) const;
 
     const char* asCString() const; // Embedded zeroes could cause you trouble!
     std::string asString() const; // Embedded zeroes are possible.
@@ -173,6 +327,11 @@ public:
     const Value& operator[](int index) const;
     Value get(uint32_t index, const Value& defaultValue) const;
     bool isValidIndex(uint32_t index) const;
+    /// @brief Trim container storage to exact size, recursively. Call once a
+    /// tree is fully built (e.g. after parsing, before serializing): the
+    /// flat containers are already sorted and contiguous, so this releases
+    /// the growth slack and a whole-tree walk reads packed minimal memory.
+    void shrinkToFit();
     Value& append(const Value& value);
     Value& append(Value&& value);
     bool insert(uint32_t index, const Value& newValue);
@@ -187,6 +346,11 @@ public:
     Value get(const std::string& key, const Value& defaultValue) const;
     Value const* find(char const* begin, char const* end) const;
     Value* demand(char const* begin, char const* end);
+    // Arena flavor for parsers building a document whose arena outlives the
+    // tree: long key bytes are bump-copied into the arena and borrowed by
+    // the stored key -- no per-key heap block while the arena is alive.
+    // Pairs with the arena string constructor above.
+    Value* demand(StringArena* arena, char const* begin, char const* end);
     void removeMember(const char* key);
     void removeMember(const std::string& key);
     bool removeMember(const char* key, Value* removed);
@@ -198,9 +362,15 @@ public:
     bool isMember(const char* begin, const char* end) const;
     std::vector<std::string> getMemberNames() const;
 
-    void setComment(std::string comment, CommentPlacement placement);
-    void setComment(const char* comment, size_t len, CommentPlacement placement) {
-        setComment(std::string(comment, len), placement);
+    /// The sized form is the primitive: the bytes go straight into the
+    /// packed comment blob, so neither wrapper ever materializes a
+    /// std::string on the way in.
+    void setComment(const char* comment, size_t length, CommentPlacement placement);
+    void setComment(const char* comment, CommentPlacement placement) {
+        setComment(comment, __builtin_strlen(comment), placement);
+    }
+    void setComment(const std::string& comment, CommentPlacement placement) {
+        setComment(comment.data(), comment.size(), placement);
     }
 
     bool hasComment(CommentPlacement placement) const;
@@ -230,6 +400,22 @@ private:
     void dupPayload(const Value& other);
     void releasePayload();
     void dupMeta(const Value& other);
+    void storeString(const char* str, unsigned int length);
+    const char* rawString(unsigned int* length) const;
+
+    // Per-type three-way comparators; operator< and operator== dispatch
+    // through a table indexed by value_type so each arm stays small.
+    static int compareNull(const Value& a, const Value& b);
+    static int compareInt(const Value& a, const Value& b);
+    static int compareUInt(const Value& a, const Value& b);
+    static int compareReal(const Value& a, const Value& b);
+    static int compareString(const Value& a, const Value& b);
+    static int compareBool(const Value& a, const Value& b);
+    static int compareArray(const Value& a, const Value& b);
+    static int compareObject(const Value& a, const Value& b);
+
+    typedef int (*TypeCompare)(const Value& a, const Value& b);
+    static const TypeCompare typeCompare[8];
 
     Value& resolveReference(const char* key);
     Value& resolveReference(const char* key, const char* end);
@@ -240,7 +426,12 @@ private:
         double v_real;
         bool v_bool;
         char* v_string; // if allocated_, ptr to { unsigned, char[] }.
+        // Short strings in place (see inline_str). Sized at 16 so payloads
+        // up to 15 chars -- the overwhelming majority in real documents --
+        // never touch the heap; scalars still use only the first 8 bytes.
+        char v_sbuf[16];
         ObjectValues* v_map;
+        ArrayValues* v_array;
     } m_value;
 
     struct {
@@ -248,28 +439,99 @@ private:
         unsigned int value_type : 8;
         // Unless allocated_, string_ must be null-terminated.
         unsigned int allocated : 1;
+        // String payload lives in v_sbuf rather than behind v_string.
+        unsigned int inline_str : 1;
+        unsigned int inline_len : 4;
+        // v_string is a prefixed block owned by a StringArena; never freed here.
+        unsigned int arena_str : 1;
+        // For realValue: v_real is neither zero nor NaN. Computed once at
+        // construction so asBool() is a bit test, not an fpclassify call.
+        unsigned int real_nonzero : 1;
+        // This value has an entry in the comments side table.
+        unsigned int has_comments : 1;
+        // Comments or source offsets are present; copies skip all metadata
+        // work when this is clear (the 99% case for parsed values).
+        unsigned int has_meta : 1;
     } m_bits;
+    // Cached string payload length (0 for every other type). Fills the
+    // padding after m_bits, so equality can reject on length and the
+    // comparators never re-read the heap block's length prefix.
+    uint32_t m_strLen;
 
     class Comments {
     public:
-        Comments() = default;
+        Comments() : m_blob(nullptr) {}
         Comments(const Comments& that);
-        Comments(Comments&& that) noexcept;
+        Comments(Comments&& that) noexcept : m_blob(that.m_blob) { that.m_blob = nullptr; }
+        ~Comments();
         Comments& operator=(const Comments& that);
         Comments& operator=(Comments&& that) noexcept;
         bool has(CommentPlacement slot) const;
         std::string get(CommentPlacement slot) const;
-        void set(CommentPlacement slot, std::string comment);
+        void set(CommentPlacement slot, const char* comment, uint32_t length);
 
     private:
-        using Array = std::array<std::string, numberOfCommentPlacement>;
-        std::unique_ptr<Array> m_ptr;
+        // One packed heap block holding every set slot:
+        //   { uint32_t off[numberOfCommentPlacement]; uint32_t end; char data[] }
+        // Slot bytes are data[off[slot]] up to the next set slot's offset (or
+        // end); off[slot] == noComment marks an absent slot. Comments are
+        // written once and read rarely, so rebuilding the blob on set() in
+        // exchange for one allocation per commented value -- instead of three
+        // strings behind a unique_ptr -- is the right trade.
+        static constexpr uint32_t noComment = uint32_t(-1);
+
+        char* m_blob;
     };
 
-    Comments m_comments;
-    // [start, limit) byte offsets in the source JSON text from which this Value was extracted.
-    ptrdiff_t m_start;
-    ptrdiff_t m_limit;
+    // Everything a Value only sometimes carries: comments plus the
+    // [start, limit) byte offsets in the source JSON text it was extracted
+    // from. Well under 1% of parsed values have either, so the block lives
+    // in a process-wide, mutex-guarded side table keyed by value address
+    // instead of costing every Value 16 bytes of offsets and a comments
+    // slot. m_bits.has_meta gates all table lookups (has_comments
+    // additionally marks that the comments inside are set), so the lock is
+    // never taken for metadata-free values.
+    struct ValueMeta {
+        Comments comments;
+#if defined(JSON_LARGE_OFFSETS)
+        ptrdiff_t start = 0;
+        ptrdiff_t length = 0;
+#else
+        // A compact (start, length) pair: the limit is only ever read back
+        // as start + length, and 32 bits cover any sane document. Builds
+        // that really index JSON past 2GB define JSON_LARGE_OFFSETS.
+        int32_t start = 0;
+        uint32_t length = 0;
+#endif
+    };
+    static std::unordered_map<const Value*, ValueMeta>& metaTable();
+};
+
+/// Small-buffer string for path arguments. A Path call carries five
+/// default arguments, so the empty and short-key cases must not allocate:
+/// keys up to 15 bytes live inline, keys passed as C strings are borrowed
+/// without copying, and only long owned keys touch the heap.
+class SmallStr {
+public:
+    SmallStr() : m_length(0), m_mode(modeInline) { m_buf[0] = '\0'; }
+    SmallStr(const char* str, size_t length, bool borrow);
+    SmallStr(const SmallStr& other);
+    SmallStr(SmallStr&& other) noexcept;
+    ~SmallStr();
+    SmallStr& operator=(const SmallStr& other);
+    SmallStr& operator=(SmallStr&& other) noexcept;
+
+    const char* c_str() const { return m_mode == modeInline ? m_buf : m_ptr; }
+    size_t length() const { return m_length; }
+
+private:
+    enum Mode { modeInline = 0, modeBorrowed, modeOwned };
+    union {
+        char m_buf[16];
+        const char* m_ptr;
+    };
+    uint32_t m_length;
+    uint8_t m_mode;
 };
 
 class PathArgument {
@@ -278,15 +540,30 @@ public:
     PathArgument();
     PathArgument(uint32_t index);
     PathArgument(const char* key);
-    PathArgument(std::string key);
+    PathArgument(const std::string& key);
+    PathArgument(const PathArgument& other);
+    PathArgument(PathArgument&& other) noexcept;
+    ~PathArgument();
+    PathArgument& operator=(const PathArgument& other);
+    PathArgument& operator=(PathArgument&& other) noexcept;
 
 private:
     enum Kind { kindNone = 0, kindIndex, kindKey };
-    std::string m_key;
-    uint32_t m_index{};
-    Kind kind_{kindNone};
+
+    // An argument is an index or a key, never both, so the two share
+    // storage; only kindKey has a live SmallStr to construct, copy and
+    // destroy. Index arguments are plain 4-byte values end to end.
+    union {
+        SmallStr m_key;   // kindKey
+        uint32_t m_index; // kindIndex
+    };
+    uint8_t kind_{kindNone};
 };
 
+// A Path is compiled once: the constructor parses the path string (and
+// splices in any '%' arguments) into a flat vector of index/key ops, so
+// every resolve()/make() call is pure execution -- no re-parsing and no
+// allocation per call. Cache one instance per repeatedly used path.
 class Path {
 public:
     Path(const std::string& path, const PathArgument& a1 = PathArgument(),
@@ -313,10 +590,18 @@ private:
     Args m_args;
 };
 
+// Iteration covers both container representations: objects walk the flat
+// (key, value) entry array, arrays walk the element vector, and both are
+// contiguous. Every per-element operation is defined here in the header so
+// a begin()..end() loop compiles down to a raw pointer walk -- no
+// out-of-line call per element.
 class ValueIteratorBase {
 public:
-    ValueIteratorBase();
-    explicit ValueIteratorBase(const Value::ObjectValues::iterator& current);
+    ValueIteratorBase() {}
+    explicit ValueIteratorBase(const Value::ObjectValues::iterator& current)
+        : m_object(current), m_kind(kindObject) {}
+    ValueIteratorBase(const Value::ArrayValues::iterator& current, uint32_t index)
+        : m_array(current), m_index(index), m_kind(kindArray) {}
 
     bool operator==(const ValueIteratorBase& other) const { return isEqual(other); }
     bool operator!=(const ValueIteratorBase& other) const { return !isEqual(other); }
@@ -330,17 +615,68 @@ public:
     char const* memberName(char const** end) const;
 
 protected:
-    const Value& deref() const;
-    Value& deref();
-    void increment();
-    void decrement();
-    int computeDistance(const ValueIteratorBase& other) const;
-    bool isEqual(const ValueIteratorBase& other) const;
-    void copy(const ValueIteratorBase& other);
+    const Value& deref() const {
+        return m_kind == kindArray ? *m_array : m_object->second;
+    }
+    Value& deref() {
+        return m_kind == kindArray ? *m_array : m_object->second;
+    }
+
+    void increment() {
+        if (m_kind == kindArray) {
+            ++m_array;
+            ++m_index;
+        } else if (m_kind == kindObject) {
+            ++m_object;
+        }
+    }
+
+    void decrement() {
+        if (m_kind == kindArray) {
+            --m_array;
+            --m_index;
+        } else if (m_kind == kindObject) {
+            --m_object;
+        }
+    }
+
+    int computeDistance(const ValueIteratorBase& other) const {
+        if (m_kind == kindArray) {
+            return static_cast<int>(other.m_array - m_array);
+        }
+        if (m_kind == kindObject) {
+            return static_cast<int>(other.m_object - m_object);
+        }
+        return 0;
+    }
+
+    bool isEqual(const ValueIteratorBase& other) const {
+        if (m_kind != other.m_kind) {
+            return false;
+        }
+        if (m_kind == kindArray) {
+            return m_array == other.m_array;
+        }
+        if (m_kind == kindObject) {
+            return m_object == other.m_object;
+        }
+        return true; // both null
+    }
+
+    void copy(const ValueIteratorBase& other) {
+        m_object = other.m_object;
+        m_array = other.m_array;
+        m_index = other.m_index;
+        m_kind = other.m_kind;
+    }
 
 private:
-    Value::ObjectValues::iterator m_current;
-    bool m_isNull{true};
+    enum Kind { kindNull = 0, kindObject, kindArray };
+
+    Value::ObjectValues::iterator m_object;
+    Value::ArrayValues::iterator m_array;
+    uint32_t m_index{0};
+    Kind m_kind{kindNull};
 };
 
 class ValueConstIterator : public ValueIteratorBase {
@@ -374,7 +710,11 @@ public:
     const Value* operator->() const { return &deref(); }
 
 private:
-    explicit ValueConstIterator(const Value::ObjectValues::iterator& current);
+friend class Value;
+    explicit ValueConstIterator(const Value::ObjectValues::iterator& current)
+        : ValueIteratorBase(current) {}
+    ValueConstIterator(const Value::ArrayValues::iterator& current, uint32_t index)
+        : ValueIteratorBase(current, index) {}
 };
 
 class ValueIterator : public ValueIteratorBase {
@@ -414,9 +754,125 @@ public:
     Value* operator->() const { return const_cast<Value*>(&deref()); }
 
 private:
-    explicit ValueIterator(const Value::ObjectValues::iterator& current);
+friend class Value;
+    explicit ValueIterator(const Value::ObjectValues::iterator& current)
+        : ValueIteratorBase(current) {}
+    ValueIterator(const Value::ArrayValues::iterator& current, uint32_t index)
+        : ValueIteratorBase(current, index) {}
 };
 
+// Hot small members live here so copy/swap/construct chains inline away;
+// always_inline keeps them flat even in debug-friendly builds.
+__attribute__((always_inline)) inline void Value::initBasic(ValueType type, bool allocated) {
+    setType(type);
+    setIsAllocated(allocated);
+    m_bits.inline_str = 0;
+    m_bits.inline_len = 0;
+    m_bits.arena_str = 0;
+    m_bits.real_nonzero = 0;
+    m_bits.has_comments = 0;
+    m_bits.has_meta = 0;
+    m_strLen = 0;
+}
+
+inline Value::Value(int32_t value) {
+    initBasic(intValue);
+    m_value.v_int = value;
+}
+
+inline Value::Value(uint32_t value) {
+    initBasic(uintValue);
+    m_value.v_uint = value;
+}
+
+inline Value::Value(int64_t value) {
+    initBasic(intValue);
+    m_value.v_int = value;
+}
+
+inline Value::Value(uint64_t value) {
+    initBasic(uintValue);
+    m_value.v_uint = value;
+}
+
+inline Value::Value(double value) {
+    initBasic(realValue);
+    m_value.v_real = value;
+    m_bits.real_nonzero = (value != 0.0) && !std::isnan(value);
+}
+
+inline Value::Value(bool value) {
+    initBasic(boolValue);
+    m_value.v_bool = value;
+}
+
+inline Value::Value(Value&& other) noexcept {
+    initBasic(nullValue);
+    swap(other);
+}
+
+inline Value& Value::operator=(Value&& other) noexcept {
+    other.swap(*this);
+    return *this;
+}
+
+inline bool Value::isNull() const {
+    return type() == nullValue;
+}
+
+// The member-access fast path: __builtin_strlen folds to a constant for
+// literal keys, and prefetching the member array starts its fetch while the
+// lookup key is still being packed -- which hides most of the latency in
+// value["x"]["y"]["z"] chains.
+inline Value& Value::operator[](const char* key) {
+    if (__builtin_expect(type() == objectValue, 1)) {
+        __builtin_prefetch(m_value.v_map);
+    }
+    return resolveReference(key, key + __builtin_strlen(key));
+}
+
+inline const Value& Value::operator[](const char* key) const {
+    if (__builtin_expect(type() == objectValue, 1)) {
+        __builtin_prefetch(m_value.v_map);
+    }
+    const Value* found = find(key, key + __builtin_strlen(key));
+    return found ? *found : nullSingleton();
+}
+
+inline Value& Value::operator[](const std::string& key) {
+    return resolveReference(key.data(), key.data() + key.length());
+}
+
+inline const Value& Value::operator[](const std::string& key) const {
+    const Value* found = find(key.data(), key.data() + key.length());
+    return found ? *found : nullSingleton();
+}
+
+inline Value& Value::operator[](const StaticString& key) {
+    return resolveReference(key.c_str());
+}
+
+inline ValueType Value::type() const {
+    return static_cast<ValueType>(m_bits.value_type);
+}
+
+__attribute__((always_inline)) inline void Value::swapPayload(Value& other) {
+    // Comments and source offsets stay in place: the side-table entries are
+    // keyed by address, so each side keeps its own has_comments/has_meta
+    // bits. swap() exchanges them by hand along with the table entries.
+    unsigned int thisComments = m_bits.has_comments;
+    unsigned int thisMeta = m_bits.has_meta;
+    unsigned int otherComments = other.m_bits.has_comments;
+    unsigned int otherMeta = other.m_bits.has_meta;
+    std::swap(m_bits, other.m_bits);
+    std::swap(m_strLen, other.m_strLen);
+    std::swap(m_value, other.m_value);
+    m_bits.has_comments = thisComments;
+    m_bits.has_meta = thisMeta;
+    other.m_bits.has_comments = otherComments;
+    other.m_bits.has_meta = otherMeta;
+}
+
 inline void swap(Value& a, Value& b) { a.swap(b); }
 
 inline const Value& Value::front() const { return *begin(); }
@@ -1,36 +1,41 @@
 #include <cassert>
 #include <iostream>
 #include <string>
+#include "utils.h"
+#include "value.h"
 
 static int64_t minLargestInt = int64_t(~(uint64_t(-1) / 2));
 static int64_t maxLargestInt = int64_t(uint64_t(-1) / 2);
 
-static void uintToString(uint64_t value, char*& current) {
-    *--current = 0;
-    do {
-        *--current = static_cast<char>(value % 10U + static_cast<unsigned>('0'));
-        value /= 10;
-    } while (value != 0);
-}
-
-std::string valueToString(int64_t value) {
-    char buffer[3 * 64 / 8 + 1];
-    char* current = buffer + sizeof(buffer);
-    if (value == minLargestInt) {
-        uintToString(uint64_t(maxLargestInt) + 1, current);
-        *--current = '-';
-    } else if (value < 0) {
-        uintToString(uint64_t(-value), current);
-        *--current = '-';
-    } else {
-        uintToString(uint64_t(value), current);
-    }
-    assert(current >= buffer);
-    return current;
-}
-
 int main() {
+    using JsonCPP::valueToString;
+    assert(valueToString(int64_t(0)) == "0");
+    assert(valueToString(int64_t(-1)) == "-1");
+    assert(valueToString(int64_t(99999)) == "99999");
+    assert(valueToString(minLargestInt) == "-9223372036854775808");
+    assert(valueToString(maxLargestInt) == "9223372036854775807");
+    assert(valueToString(uint64_t(-1)) == "18446744073709551615");
+    assert(valueToString(uint64_t(10000000000000000000ull)) == "10000000000000000000");
     int64_t a = 99999;
     std::cout << valueToString(a) << std::endl;
+
+    // Aliased assignment: the source lives inside the destination, so the
+    // old payload must outlive the copy.
+    {
+        using JsonCPP::Value;
+        Value root(JsonCPP::objectValue);
+        root["child"] = Value(JsonCPP::arrayValue);
+        root["child"].append(Value(1));
+        root["other"] = Value("x");
+        root = root["child"]; // type mismatch path
+        assert(root.isArray());
+        assert(root[uint32_t(0)].asInt() == 1);
+
+        Value tree(JsonCPP::objectValue);
+        tree["child"]["leaf"] = Value(2);
+        tree = tree["child"]; // same-type object reuse path
+        assert(tree.isObject());
+        assert(tree["leaf"].asInt() == 2);
+    }
     return 0;
-}
\ No newline at end of file
+}